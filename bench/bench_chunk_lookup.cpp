@@ -0,0 +1,129 @@
+// Chunk lookup microbenchmark: the containers and hashes ChunkManager has used
+// for its loaded chunks, over the chunk coordinates of a load sphere.
+//
+//   bench_chunk_lookup [radius] [lookups]
+//
+// Random lookups compare the old xor-shift hash and the current hash in
+// std::unordered_map with FlatHashMap. Ray walks then compare FlatHashMap with
+// and without getChunk's last-hit cache, stepping voxel by voxel as castRay does.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/ChunkManager.h"
+
+namespace {
+
+// std::hash<ChunkCoord> before the mixing hash
+struct XorShiftCoordHash {
+    size_t operator()(const Chunk::ChunkCoord& c) const {
+        return ((std::hash<int>()(c.x) ^ (std::hash<int>()(c.y) << 1)) >> 1) ^ (std::hash<int>()(c.z) << 1);
+    }
+};
+
+// Mirrors ChunkManager::getChunk
+struct LastHitLookup {
+    const FlatHashMap<Chunk::ChunkCoord, int>& chunks;
+    Chunk::ChunkCoord lastHitCoord{};
+    const int* lastHit = nullptr;
+
+    const int* get(const Chunk::ChunkCoord& coord) {
+        if (lastHit && coord == lastHitCoord) return lastHit;
+        auto it = chunks.find(coord);
+        if (it == chunks.end()) return nullptr;
+        lastHitCoord = coord;
+        lastHit = &it->second;
+        return lastHit;
+    }
+};
+
+template <typename Lookup>
+void run(const char* name, size_t count, Lookup&& lookup) {
+    auto start = std::chrono::steady_clock::now();
+    long long sum = lookup();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-34s %9.2f ms %7.2f ns/lookup  (checksum %lld)\n", name, ms, ms * 1e6 / double(count), sum);
+}
+
+template <typename Map>
+long long lookupAll(const Map& map, const std::vector<Chunk::ChunkCoord>& queries) {
+    long long sum = 0;
+    for (const auto& coord : queries) {
+        auto it = map.find(coord);
+        if (it != map.end()) sum += it->second;
+    }
+    return sum;
+}
+
+int floorDiv(int value, int divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int radius = argc > 1 ? std::atoi(argv[1]) : 8;
+    size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000000;
+
+    std::vector<Chunk::ChunkCoord> sphere;
+    for (int x = -radius; x <= radius; ++x) {
+        for (int y = -radius; y <= radius; ++y) {
+            for (int z = -radius; z <= radius; ++z) {
+                if (x * x + y * y + z * z <= radius * radius) sphere.push_back({x, y, z});
+            }
+        }
+    }
+
+    std::unordered_map<Chunk::ChunkCoord, int, XorShiftCoordHash> oldHashMap;
+    std::unordered_map<Chunk::ChunkCoord, int> newHashMap;
+    FlatHashMap<Chunk::ChunkCoord, int> flatMap;
+    for (size_t i = 0; i < sphere.size(); ++i) {
+        oldHashMap[sphere[i]] = static_cast<int>(i);
+        newHashMap[sphere[i]] = static_cast<int>(i);
+        flatMap[sphere[i]] = static_cast<int>(i);
+    }
+
+    size_t largestBucket = 0;
+    for (size_t b = 0; b < oldHashMap.bucket_count(); ++b) largestBucket = std::max(largestBucket, oldHashMap.bucket_size(b));
+    std::printf("%zu chunks within radius %d; largest xor-shift bucket holds %zu\n", sphere.size(), radius, largestBucket);
+
+    // Lookups spread over the sphere's bounding box, so some miss as they do while streaming
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> axis(-radius - 1, radius + 1);
+    std::vector<Chunk::ChunkCoord> queries(lookups);
+    for (auto& coord : queries) coord = {axis(random), axis(random), axis(random)};
+
+    run("xor-shift hash + unordered_map", lookups, [&] { return lookupAll(oldHashMap, queries); });
+    run("mixing hash + unordered_map", lookups, [&] { return lookupAll(newHashMap, queries); });
+    run("mixing hash + FlatHashMap", lookups, [&] { return lookupAll(flatMap, queries); });
+
+    // Rays from the center, one chunk lookup per voxel step until they leave the sphere
+    std::vector<Chunk::ChunkCoord> raySteps;
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+    float reach = float(radius * Chunk::CHUNK_SIZE);
+    while (raySteps.size() < lookups) {
+        glm::vec3 dir(direction(random), direction(random), direction(random));
+        if (glm::length2(dir) < 1e-4f) continue;
+        dir = glm::normalize(dir);
+        for (float t = 0.0f; t < reach && raySteps.size() < lookups; t += Chunk::VOXEL_SIZE) {
+            glm::ivec3 voxel = glm::ivec3(glm::floor(dir * t));
+            raySteps.push_back({floorDiv(voxel.x, Chunk::CHUNK_SIZE), floorDiv(voxel.y, Chunk::CHUNK_SIZE), floorDiv(voxel.z, Chunk::CHUNK_SIZE)});
+        }
+    }
+
+    run("ray walk, FlatHashMap", lookups, [&] { return lookupAll(flatMap, raySteps); });
+    run("ray walk, getChunk last-hit cache", lookups, [&] {
+        LastHitLookup chunks{flatMap};
+        long long sum = 0;
+        for (const auto& coord : raySteps) {
+            if (const int* chunk = chunks.get(coord)) sum += *chunk;
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,62 @@
+#version 450
+
+// Chunk mesh vertex shader. Decodes VoxelVertex (see src/VoxelVertex.h) and
+// produces the same outputs as shader.vert, so both share shader.frag.
+
+layout(location = 0) in uint inPositionNormal; // x8 | y8 | z8 | face3 | textureId5
+layout(location = 1) in uint inMaterial;       // r8 | g8 | b8 | a8
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec3 fragWorldPos;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec2 fragTexCoord;
+layout(location = 4) out float fragTextureId;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// model places the chunk in the world and scales voxel units to VOXEL_SIZE
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+} push;
+
+// Same face order as Chunk::addFace
+const vec3 FACE_NORMALS[6] = vec3[6](
+    vec3( 0.0,  1.0,  0.0), // Top
+    vec3( 0.0, -1.0,  0.0), // Bottom
+    vec3( 1.0,  0.0,  0.0), // Right
+    vec3(-1.0,  0.0,  0.0), // Left
+    vec3( 0.0,  0.0,  1.0), // Front
+    vec3( 0.0,  0.0, -1.0)  // Back
+);
+
+void main() {
+    vec3 localPos = vec3(
+        float(inPositionNormal & 0xFFu),
+        float((inPositionNormal >> 8) & 0xFFu),
+        float((inPositionNormal >> 16) & 0xFFu)
+    );
+    uint face = (inPositionNormal >> 24) & 0x7u;
+
+    vec4 worldPos = push.model * vec4(localPos, 1.0);
+    gl_Position = ubo.proj * ubo.view * worldPos;
+    fragWorldPos = worldPos.xyz;
+    // The model matrix scales by VOXEL_SIZE, so the normal is renormalized
+    fragNormal = normalize(mat3(push.model) * FACE_NORMALS[face]);
+
+    // Texture axes per face, matching the old per-quad UV layout. Corners sit on
+    // whole voxels and the sampler repeats, so the texture tiles once per voxel.
+    vec2 uv;
+    if (face == 0u)      uv = localPos.xz;
+    else if (face == 1u) uv = localPos.zx;
+    else if (face == 2u) uv = localPos.zy;
+    else if (face == 3u) uv = localPos.yz;
+    else if (face == 4u) uv = localPos.yx;
+    else                 uv = localPos.xy;
+    fragTexCoord = uv;
+
+    fragTextureId = float(inPositionNormal >> 27);
+    fragColor = unpackUnorm4x8(inMaterial);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+// Fixed-length array of small unsigned integers packed into 64-bit words.
+// Entry width is always a power of two (0, 1, 2, 4, 8, 16 or 32 bits) so an entry
+// never straddles two words. A width of 0 means every entry is 0 and no
+// memory is allocated at all.
+class BitPackedArray {
+public:
+    BitPackedArray() : length(0), bits(0) {}
+
+    BitPackedArray(size_t size, int bitsPerEntry)
+        : length(size), bits(bitsPerEntry) {
+        words.resize(wordCount(length, bits), 0);
+    }
+
+    // Smallest supported width able to hold values in [0, maxValue]
+    static int bitsForValue(uint32_t maxValue) {
+        if (maxValue == 0) return 0;
+        if (maxValue < 2) return 1;
+        if (maxValue < 4) return 2;
+        if (maxValue < 16) return 4;
+        if (maxValue < 256) return 8;
+        if (maxValue < 65536) return 16;
+        return 32;
+    }
+
+    uint32_t get(size_t i) const {
+        if (bits == 0) return 0;
+        size_t bitIndex = i * bits;
+        return static_cast<uint32_t>((words[bitIndex >> 6] >> (bitIndex & 63)) & mask());
+    }
+
+    void set(size_t i, uint32_t value) {
+        if (bits == 0) return; // Only 0 is representable
+        size_t bitIndex = i * bits;
+        uint64_t& word = words[bitIndex >> 6];
+        int shift = static_cast<int>(bitIndex & 63);
+        word = (word & ~(mask() << shift)) | ((static_cast<uint64_t>(value) & mask()) << shift);
+    }
+
+    // Set every entry to the same value
+    void fill(uint32_t value) {
+        if (bits == 0) return;
+        uint64_t pattern = 0;
+        for (int shift = 0; shift < 64; shift += bits) {
+            pattern |= (static_cast<uint64_t>(value) & mask()) << shift;
+        }
+        std::fill(words.begin(), words.end(), pattern);
+    }
+
+    // Repack all entries at a new width (values must fit the new width)
+    void setBitsPerEntry(int newBits) {
+        if (newBits == bits) return;
+        BitPackedArray repacked(length, newBits);
+        for (size_t i = 0; i < length; ++i) {
+            repacked.set(i, get(i));
+        }
+        *this = std::move(repacked);
+    }
+
+    int bitsPerEntry() const { return bits; }
+    size_t size() const { return length; }
+    size_t memoryUsage() const { return words.size() * sizeof(uint64_t); }
+
+    const std::vector<uint64_t>& data() const { return words; }
+    std::vector<uint64_t>& data() { return words; }
+
+private:
+    std::vector<uint64_t> words;
+    size_t length;
+    int bits;
+
+    uint64_t mask() const { return (bits >= 64) ? ~0ull : ((1ull << bits) - 1); }
+
+    static size_t wordCount(size_t size, int bitsPerEntry) {
+        return (size * static_cast<size_t>(bitsPerEntry) + 63) / 64;
+    }
+};
@@ -1,18 +1,75 @@
 #pragma once
 
 #include "Vertex.h"
+#include "VoxelVertex.h"
+#include "BitPackedArray.h"
+#include "FlatHashMap.h"
+#include "OccupancyKernels.h"
 #include <vector>
 #include <glm/glm.hpp>
 #include <cstdint>
 #include <fstream>
+#include <iterator>
+#include <bit>
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cassert>
 
 // Chunk represents a fixed-size grid of voxels
 class Chunk {
 public:
     // static constexpr int CHUNK_SIZE = 32; // 32x32x32 voxels per chunk
     static constexpr int CHUNK_SIZE = 128; // 128x128x128 voxels per chunk (for higher defintion worlds with a taller player)
+    static constexpr int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+    static constexpr int BRICK_SIZE = 16; // Voxel storage is split into 16x16x16 bricks
+    static constexpr int BRICK_VOLUME = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+    static constexpr int BRICKS_PER_AXIS = CHUNK_SIZE / BRICK_SIZE;
+    static constexpr int BRICK_COUNT = BRICKS_PER_AXIS * BRICKS_PER_AXIS * BRICKS_PER_AXIS;
+    static constexpr int WORDS_PER_ROW = CHUNK_SIZE / 64; // Occupancy rows run along x
+    static constexpr int OCCUPANCY_WORDS = CHUNK_SIZE * CHUNK_SIZE * WORDS_PER_ROW;
+    static_assert(CHUNK_SIZE % 64 == 0, "Occupancy rows must be whole 64-bit words");
+    static_assert(CHUNK_SIZE <= 255, "VoxelVertex stores chunk-relative corners in 8 bits");
+    static constexpr int SECTION_SIZE = 32; // Meshes are built and uploaded per 32x32x32 section
+    static constexpr int SECTIONS_PER_AXIS = CHUNK_SIZE / SECTION_SIZE;
+    static constexpr int SECTION_COUNT = SECTIONS_PER_AXIS * SECTIONS_PER_AXIS * SECTIONS_PER_AXIS;
+    static constexpr uint64_t ALL_SECTIONS = ~0ull >> (64 - SECTION_COUNT);
+    static_assert(SECTION_COUNT <= 64, "Section dirty flags are a 64-bit mask");
+    static_assert(64 % SECTION_SIZE == 0, "A section's rows must not straddle occupancy words");
+
+    // Face directions, same order as addFace: top, bottom, right, left, front, back.
+    // The opposite of face f is f ^ 1.
+    static constexpr int FACE_OFFSETS[6][3] = {
+        { 0,  1,  0}, { 0, -1,  0},
+        { 1,  0,  0}, {-1,  0,  0},
+        { 0,  0,  1}, { 0,  0, -1}
+    };
     static constexpr float VOXEL_SIZE = 1.0f;
-    bool meshDirty;
+    // Bump whenever buildMesh output or the mesh cache layout changes so stale
+    // cache files are rebuilt instead of loaded
+    static constexpr uint32_t MESH_CACHE_VERSION = 2;
+    // Section bit masks, bit = sectionIndexOf(...)
+    uint64_t dirtySections;              // Voxels changed since the section mesh was last built
+    uint64_t uploadPendingSections = 0;  // Rebuilt section meshes waiting to be uploaded to the GPU
+
+    // Mesh of one section. Positions are chunk-relative; bounds enclose all of its
+    // quads (boundsMin > boundsMax when the section has no faces).
+    struct SectionMesh {
+        std::vector<VoxelVertex> vertices;
+        std::vector<uint32_t> indices;
+        glm::ivec3 boundsMin{CHUNK_SIZE};
+        glm::ivec3 boundsMax{0};
+
+        void clear() {
+            vertices.clear();
+            indices.clear();
+            boundsMin = glm::ivec3(CHUNK_SIZE);
+            boundsMax = glm::ivec3(0);
+        }
+    };
     
     struct ChunkCoord {
         int x, y, z;
@@ -36,6 +93,10 @@ public:
         
         VoxelData() : color(1.0f), type(0), textureId(0) {}
         VoxelData(const glm::vec4& c, uint8_t t, int texID = 0) : color(c), type(t), textureId(texID) {}
+
+        bool operator==(const VoxelData& other) const {
+            return type == other.type && textureId == other.textureId && color == other.color;
+        }
     };
 
     // Physics data for a single voxel
@@ -54,27 +115,100 @@ public:
 
 private:
     ChunkCoord coordinate;
-    std::vector<VoxelData> voxels; // Flat array: index = x + y*SIZE + z*SIZE*SIZE
+
+    // A brick is either uniform (one palette index for all its voxels, no index
+    // array) or materialized with one bit-packed index per voxel.
+    struct Brick {
+        uint32_t uniformIndex = 0;
+        BitPackedArray indices; // Local index = x + y*BRICK_SIZE + z*BRICK_SIZE*BRICK_SIZE
+
+        bool isUniform() const { return indices.size() == 0; }
+    };
+
+    // Palette compressed, sparse voxel storage. Every distinct voxel value is stored
+    // once in the palette; bricks hold palette indices whose width grows with the
+    // palette size. palette[0] is always air. An empty brick table means the whole
+    // chunk is air.
+    std::vector<VoxelData> palette;
+    std::vector<uint32_t> paletteRefCounts; // Voxels referencing each entry, 0 = reusable slot
+    // Referenced solid entries by value, and the slots whose count dropped to 0,
+    // so adding a voxel value never scans the palette
+    struct VoxelDataHash {
+        size_t operator()(const VoxelData& voxel) const {
+            uint32_t channels[4];
+            for (int c = 0; c < 4; ++c) {
+                float value = voxel.color[c] + 0.0f; // -0 and 0 compare equal, so hash alike
+                std::memcpy(&channels[c], &value, sizeof(float));
+            }
+            uint64_t hash = mixHash(voxel.type, static_cast<uint32_t>(voxel.textureId));
+            hash = mixHash(hash, channels[0] | (uint64_t(channels[1]) << 32));
+            return mixHash(hash, channels[2] | (uint64_t(channels[3]) << 32));
+        }
+    };
+    FlatHashMap<VoxelData, uint32_t, VoxelDataHash> paletteLookup;
+    std::vector<uint32_t> freePaletteSlots;
+    std::vector<Brick> bricks; // Brick index = bx + by*BRICKS_PER_AXIS + bz*BRICKS_PER_AXIS^2
+    int indexBits;
+    uint32_t lastPaletteLookup;
+
+    // One bit per voxel, set when solid. Word = (y + z*SIZE)*WORDS_PER_ROW + x/64, bit = x%64.
+    // Kept in sync by setVoxel; left unallocated while the chunk is all air.
+    std::vector<uint64_t> occupancy;
+
+    // Loaded chunks adjacent in each face direction, maintained by ChunkManager
+    Chunk* neighbors[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
     
-    // Cached mesh data
-    std::vector<Vertex> vertexCache;
-    std::vector<uint32_t> indexCache;
+    // Cached mesh data, one mesh per section
+    std::array<SectionMesh, SECTION_COUNT> sectionMeshes;
+
+    // Sections being edited interactively hold one unit quad per visible face instead
+    // of a greedy mesh, so a single voxel edit rewrites a handful of quads in place.
+    struct SectionPatch {
+        std::unordered_map<uint32_t, uint32_t> faceToQuad; // (local voxel index * 6 + face) -> quad slot
+        std::vector<uint32_t> freeQuads;                   // Degenerate slots ready for reuse
+        uint32_t dirtyBegin = UINT32_MAX;                  // Quad range changed since the last upload
+        uint32_t dirtyEnd = 0;
+
+        void markDirty(uint32_t quad) {
+            dirtyBegin = std::min(dirtyBegin, quad);
+            dirtyEnd = std::max(dirtyEnd, quad + 1);
+        }
+    };
+    std::array<std::unique_ptr<SectionPatch>, SECTION_COUNT> sectionPatches;
+    uint64_t patchedSections = 0;
+
+    // Border layers of neighbors that are not linked yet but whose faces were culled
+    // when the current meshes were built, e.g. meshes from the mesh cache. Checked
+    // when the neighbor links, so an unchanged neighbor needs no remesh.
+    std::array<uint64_t, 6> cachedBorderHashes{};
+    uint8_t cachedBorderMask = 0;
+    bool meshCacheStale = true; // Meshes differ from the cache file on disk
     
     bool isEmpty;
 
 public:
     Chunk(const ChunkCoord& coord) 
-        : coordinate(coord), 
-          meshDirty(true),
+        : dirtySections(ALL_SECTIONS),
+          coordinate(coord), 
           isEmpty(true) {
-        voxels.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+        resetStorage();
     }
 
     void fillVoxels(const VoxelData& voxel) {
-        for (int x = 0; x < CHUNK_SIZE; ++x)
-            for (int y = 0; y < CHUNK_SIZE; ++y)
-                for (int z = 0; z < CHUNK_SIZE; ++z)
-                    setVoxel(x, y, z, voxel);
+        resetStorage();
+        if (voxel.type != 0) {
+            // A single solid entry: every brick collapses to it
+            palette.push_back(voxel);
+            paletteRefCounts[0] = 0;
+            paletteRefCounts.push_back(CHUNK_VOLUME);
+            paletteLookup[voxel] = 1;
+            indexBits = 1;
+            bricks.assign(BRICK_COUNT, Brick());
+            for (Brick& brick : bricks) brick.uniformIndex = 1;
+            occupancy.assign(OCCUPANCY_WORDS, ~0ull);
+            isEmpty = false;
+        }
+        dirtySections = ALL_SECTIONS;
     }
     
     // Get world position of chunk origin
@@ -95,27 +229,275 @@ public:
             y < 0 || y >= CHUNK_SIZE || 
             z < 0 || z >= CHUNK_SIZE) return;
         
-        int index = x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE;
-        voxels[index] = data;
-        meshDirty = true;
+        bool solidityChanged = setPaletteIndex(x, y, z, findOrAddPaletteEntry(data));
+        dirtySections |= 1ull << sectionIndexOf(x, y, z);
         
         if (data.type != 0) isEmpty = false;
+
+        // A voxel changing solidity exposes or hides faces of the voxels next to it,
+        // which may sit in another section or, on the border, in the adjacent chunk
+        if (solidityChanged) {
+            for (int face = 0; face < 6; ++face) {
+                int nx = x + FACE_OFFSETS[face][0];
+                int ny = y + FACE_OFFSETS[face][1];
+                int nz = z + FACE_OFFSETS[face][2];
+                if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= CHUNK_SIZE || nz < 0 || nz >= CHUNK_SIZE) {
+                    Chunk* neighbor = neighbors[face];
+                    if (neighbor && !neighbor->empty()) {
+                        int wrap = CHUNK_SIZE;
+                        neighbor->dirtySections |= 1ull << sectionIndexOf((nx + wrap) % wrap, (ny + wrap) % wrap, (nz + wrap) % wrap);
+                    }
+                } else {
+                    dirtySections |= 1ull << sectionIndexOf(nx, ny, nz);
+                }
+            }
+        }
+    }
+
+    // Set a voxel and patch the affected faces into the section meshes right away
+    // instead of queueing a rebuild. Used for interactive painting; call
+    // finishPatching when the stroke ends to get greedy meshes back.
+    void setVoxelPatched(int x, int y, int z, const VoxelData& data) {
+        if (x < 0 || x >= CHUNK_SIZE || 
+            y < 0 || y >= CHUNK_SIZE || 
+            z < 0 || z >= CHUNK_SIZE) return;
+
+        setPaletteIndex(x, y, z, findOrAddPaletteEntry(data));
+        if (data.type != 0) isEmpty = false;
+
+        beginPatching(sectionIndexOf(x, y, z));
+        for (int face = 0; face < 6; ++face) {
+            patchFace(x, y, z, face);
+
+            // The facing side of the voxel next to it
+            int nx = x + FACE_OFFSETS[face][0];
+            int ny = y + FACE_OFFSETS[face][1];
+            int nz = z + FACE_OFFSETS[face][2];
+            if (nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+                patchFace(nx, ny, nz, face ^ 1);
+            } else if (neighbors[face] && !neighbors[face]->empty()) {
+                int wrap = CHUNK_SIZE;
+                neighbors[face]->patchFace((nx + wrap) % wrap, (ny + wrap) % wrap, (nz + wrap) % wrap, face ^ 1);
+            }
+        }
+    }
+
+    // Drop the unit-quad meshes of patched sections and queue them for greedy
+    // remeshing. The unit meshes stay in place until the rebuilt ones arrive.
+    void finishPatching() {
+        dirtySections |= patchedSections;
+        for (uint64_t bits = patchedSections; bits; bits &= bits - 1) {
+            sectionPatches[std::countr_zero(bits)].reset();
+        }
+        patchedSections = 0;
+    }
+
+    bool isPatching() const { return patchedSections != 0; }
+    bool isSectionPatched(int section) const { return (patchedSections >> section) & 1; }
+
+    // Quad range of a patched section rewritten since the last call; false when
+    // nothing changed or the section is not patched
+    bool takePatchedRange(int section, uint32_t& firstQuad, uint32_t& endQuad) {
+        SectionPatch* patch = sectionPatches[section].get();
+        if (!patch || patch->dirtyBegin >= patch->dirtyEnd) return false;
+        firstQuad = patch->dirtyBegin;
+        endQuad = patch->dirtyEnd;
+        patch->dirtyBegin = UINT32_MAX;
+        patch->dirtyEnd = 0;
+        return true;
+    }
+
+    // True when face `faceIndex` of the voxel borders air (or an unloaded neighbor)
+    bool isFaceExposed(int x, int y, int z, int faceIndex) const {
+        int nx = x + FACE_OFFSETS[faceIndex][0];
+        int ny = y + FACE_OFFSETS[faceIndex][1];
+        int nz = z + FACE_OFFSETS[faceIndex][2];
+        if (nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+            return !isSolid(nx, ny, nz);
+        }
+        const Chunk* neighbor = neighbors[faceIndex];
+        if (!neighbor) return true;
+        int wrap = CHUNK_SIZE;
+        return !neighbor->isSolid((nx + wrap) % wrap, (ny + wrap) % wrap, (nz + wrap) % wrap);
+    }
+
+    // Neighbor links, set by ChunkManager as chunks load and unload
+    Chunk* getNeighbor(int faceIndex) const { return neighbors[faceIndex]; }
+    void setNeighbor(int faceIndex, Chunk* neighbor) { neighbors[faceIndex] = neighbor; }
+
+    // Remesh the neighbor's sections that touch this chunk after it was linked. A
+    // neighbor whose meshes were culled against a recorded border is only remeshed
+    // if this chunk's border differs from it.
+    void markNeighborDirty(int faceIndex) {
+        Chunk* neighbor = neighbors[faceIndex];
+        if (!neighbor || neighbor->empty()) return;
+        int side = faceIndex ^ 1;
+        bool remesh = !isEmpty;
+        if (neighbor->cachedBorderMask & (1u << side)) {
+            neighbor->cachedBorderMask &= ~(1u << side);
+            remesh = neighbor->cachedBorderHashes[side] != hashLayer(extractBorderLayer(faceIndex));
+        }
+        if (remesh) neighbor->dirtySections |= borderSections(side);
+    }
+
+    // The neighbor on faceIndex is about to go away. Clean border sections were
+    // culled against it, so remember its border for when it comes back.
+    void recordDepartingNeighbor(int faceIndex) {
+        Chunk* neighbor = neighbors[faceIndex];
+        if (!neighbor) return;
+        if (dirtySections & borderSections(faceIndex)) {
+            // Partly meshed against it; rebuild the whole side against air
+            dirtySections |= borderSections(faceIndex);
+            cachedBorderMask &= ~(1u << faceIndex);
+        } else {
+            cachedBorderHashes[faceIndex] = hashLayer(neighbor->extractBorderLayer(faceIndex ^ 1));
+            cachedBorderMask |= 1u << faceIndex;
+        }
+    }
+
+    static int sectionIndexOf(int x, int y, int z) {
+        return (x / SECTION_SIZE) + (y / SECTION_SIZE) * SECTIONS_PER_AXIS + (z / SECTION_SIZE) * SECTIONS_PER_AXIS * SECTIONS_PER_AXIS;
+    }
+
+    static glm::ivec3 sectionOrigin(int section) {
+        return glm::ivec3(section % SECTIONS_PER_AXIS,
+                          (section / SECTIONS_PER_AXIS) % SECTIONS_PER_AXIS,
+                          section / (SECTIONS_PER_AXIS * SECTIONS_PER_AXIS)) * SECTION_SIZE;
+    }
+
+    // Sections on one side of the chunk (face order as addFace)
+    static uint64_t borderSections(int faceIndex) {
+        uint64_t mask = 0;
+        int axis = (faceIndex < 2) ? 1 : (faceIndex < 4) ? 0 : 2;
+        int layer = (faceIndex % 2 == 0) ? SECTIONS_PER_AXIS - 1 : 0;
+        for (int section = 0; section < SECTION_COUNT; ++section) {
+            if (sectionOrigin(section)[axis] / SECTION_SIZE == layer) mask |= 1ull << section;
+        }
+        return mask;
+    }
+
+    // Occupancy of the single voxel layer on one side of the chunk, used by the
+    // neighbor on that side to cull its border faces. Layout depends on the axis:
+    // Y sides: row z at [z*WORDS_PER_ROW], bits along x
+    // X sides: one bit per occupancy row, bit index y + z*SIZE
+    // Z sides: row y at [y*WORDS_PER_ROW], bits along x
+    // Empty when the layer holds no solid voxels.
+    std::vector<uint64_t> extractBorderLayer(int faceIndex) const {
+        std::vector<uint64_t> layer;
+        if (occupancy.empty()) return layer;
+
+        constexpr int sliceStride = CHUNK_SIZE * WORDS_PER_ROW;
+        switch (faceIndex) {
+            case 0: // y = SIZE-1
+            case 1: { // y = 0
+                int y = (faceIndex == 0) ? CHUNK_SIZE - 1 : 0;
+                layer.resize(CHUNK_SIZE * WORDS_PER_ROW);
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    const uint64_t* row = &occupancy[(y + z * CHUNK_SIZE) * WORDS_PER_ROW];
+                    std::copy(row, row + WORDS_PER_ROW, &layer[z * WORDS_PER_ROW]);
+                }
+                break;
+            }
+            case 2: // x = SIZE-1
+            case 3: { // x = 0
+                int word = (faceIndex == 2) ? WORDS_PER_ROW - 1 : 0;
+                int bit = (faceIndex == 2) ? 63 : 0;
+                layer.assign(CHUNK_SIZE * CHUNK_SIZE / 64, 0);
+                for (int row = 0; row < CHUNK_SIZE * CHUNK_SIZE; ++row) {
+                    uint64_t solid = (occupancy[row * WORDS_PER_ROW + word] >> bit) & 1ull;
+                    layer[row >> 6] |= solid << (row & 63);
+                }
+                break;
+            }
+            case 4: // z = SIZE-1
+            case 5: { // z = 0
+                int base = (faceIndex == 4) ? OCCUPANCY_WORDS - sliceStride : 0;
+                layer.assign(occupancy.begin() + base, occupancy.begin() + base + sliceStride);
+                break;
+            }
+        }
+
+        for (uint64_t word : layer) {
+            if (word) return layer;
+        }
+        return {};
     }
     
     // Get voxel at local position
+    // The returned reference points into the palette and stays valid until the next setVoxel
     const VoxelData& getVoxel(int x, int y, int z) const {
         static VoxelData air;
         if (x < 0 || x >= CHUNK_SIZE || 
             y < 0 || y >= CHUNK_SIZE || 
             z < 0 || z >= CHUNK_SIZE) return air;
         
-        int index = x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE;
-        return voxels[index];
+        return palette[paletteIndexAt(x, y, z)];
     }
     
     // Check if voxel is solid
     bool isSolid(int x, int y, int z) const {
-        return getVoxel(x, y, z).type != 0;
+        if (x < 0 || x >= CHUNK_SIZE || 
+            y < 0 || y >= CHUNK_SIZE || 
+            z < 0 || z >= CHUNK_SIZE) return false;
+        if (occupancy.empty()) return false;
+        return (occupancy[occupancyWordIndex(x, y, z)] >> (x & 63)) & 1ull;
+    }
+
+    // Number of distinct voxel values currently referenced (air included)
+    size_t paletteSize() const {
+        size_t count = 0;
+        for (uint32_t refs : paletteRefCounts) {
+            if (refs > 0) ++count;
+        }
+        return count;
+    }
+
+    // Approximate heap memory used by the voxel storage
+    size_t memoryUsage() const {
+        size_t total = palette.capacity() * sizeof(VoxelData) +
+                       paletteRefCounts.capacity() * sizeof(uint32_t) +
+                       bricks.capacity() * sizeof(Brick) +
+                       occupancy.capacity() * sizeof(uint64_t);
+        for (const Brick& brick : bricks) {
+            total += brick.indices.memoryUsage();
+        }
+        return total;
+    }
+
+    // Number of bricks holding a full index array
+    int materializedBrickCount() const {
+        int count = 0;
+        for (const Brick& brick : bricks) {
+            if (!brick.isUniform()) ++count;
+        }
+        return count;
+    }
+
+    // Collapse materialized bricks whose voxels all share one value back to a
+    // single index, and drop the brick table when the whole chunk is air.
+    // Called after bulk writes (terrain generation, loading).
+    void compactBricks() {
+        bool allAir = true;
+        for (Brick& brick : bricks) {
+            if (!brick.isUniform()) {
+                uint32_t first = brick.indices.get(0);
+                bool uniform = true;
+                for (int i = 1; i < BRICK_VOLUME && uniform; ++i) {
+                    uniform = brick.indices.get(i) == first;
+                }
+                if (uniform) {
+                    brick.uniformIndex = first;
+                    brick.indices = BitPackedArray();
+                }
+            }
+            if (!brick.isUniform() || brick.uniformIndex != 0) allAir = false;
+        }
+        if (allAir) {
+            bricks.clear();
+            bricks.shrink_to_fit();
+            occupancy.clear();
+            occupancy.shrink_to_fit();
+        }
     }
 
     // Check if voxel is a surface voxel (solid and exposed to air)
@@ -126,8 +508,7 @@ public:
         }
 
         // Check 6 neighbors
-        // Using getVoxel handles out-of-bounds by returning an air voxel,
-        // which is exactly what we need for surface detection.
+        // isSolid treats out-of-bounds as air, which is exactly what we need for surface detection.
         if (!isSolid(x + 1, y, z) ||
             !isSolid(x - 1, y, z) ||
             !isSolid(x, y + 1, z) ||
@@ -139,174 +520,1091 @@ public:
 
         return false; // All neighbors are solid, so it's an interior voxel
     }
+
+    // Visible faces in one direction (0 top, 1 bottom, 2 right, 3 left, 4 front, 5 back,
+    // same as addFace) as an occupancy-layout mask: a bit is set where the voxel is solid
+    // and its neighbor in that direction is not. neighborLayer is the adjacent chunk's
+    // border layer facing this chunk (see extractBorderLayer); empty means air.
+    void computeFaceMask(int faceIndex, std::vector<uint64_t>& out,
+                         const std::vector<uint64_t>& neighborLayer = {}) const {
+        out.assign(OCCUPANCY_WORDS, 0);
+        if (occupancy.empty()) return;
+
+        const uint64_t* solid = occupancy.data();
+        const bool hasLayer = !neighborLayer.empty();
+        constexpr int rowStride = WORDS_PER_ROW;              // +1 in y
+        constexpr int sliceStride = CHUNK_SIZE * WORDS_PER_ROW; // +1 in z
+
+        switch (faceIndex) {
+            case 0: // Top (+Y): compare each row with the next row in its z-slice
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    int base = z * sliceStride;
+                    int last = base + sliceStride - rowStride;
+                    OccupancyKernels::andNot(&out[base], solid + base, solid + base + rowStride, sliceStride - rowStride);
+                    for (int w = 0; w < WORDS_PER_ROW; ++w) {
+                        out[last + w] = solid[last + w] & ~(hasLayer ? neighborLayer[z * WORDS_PER_ROW + w] : 0ull);
+                    }
+                }
+                break;
+            case 1: // Bottom (-Y)
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    int base = z * sliceStride;
+                    for (int w = 0; w < WORDS_PER_ROW; ++w) {
+                        out[base + w] = solid[base + w] & ~(hasLayer ? neighborLayer[z * WORDS_PER_ROW + w] : 0ull);
+                    }
+                    OccupancyKernels::andNot(&out[base + rowStride], solid + base + rowStride, solid + base, sliceStride - rowStride);
+                }
+                break;
+            case 2: // Right (+X): shift each row down by one bit, carrying across words
+            case 3: // Left (-X)
+                for (int row = 0; row < CHUNK_SIZE * CHUNK_SIZE; ++row) {
+                    const uint64_t* words = solid + row * WORDS_PER_ROW;
+                    uint64_t borderBit = hasLayer ? (neighborLayer[row >> 6] >> (row & 63)) & 1ull : 0ull;
+                    for (int w = 0; w < WORDS_PER_ROW; ++w) {
+                        uint64_t neighbor;
+                        if (faceIndex == 2) {
+                            neighbor = (words[w] >> 1) | ((w + 1 < WORDS_PER_ROW ? words[w + 1] : borderBit) << 63);
+                        } else {
+                            neighbor = (words[w] << 1) | (w > 0 ? words[w - 1] >> 63 : borderBit);
+                        }
+                        out[row * WORDS_PER_ROW + w] = words[w] & ~neighbor;
+                    }
+                }
+                break;
+            case 4: // Front (+Z): compare each slice with the next slice
+                OccupancyKernels::andNot(out.data(), solid, solid + sliceStride, OCCUPANCY_WORDS - sliceStride);
+                if (hasLayer) {
+                    OccupancyKernels::andNot(&out[OCCUPANCY_WORDS - sliceStride], solid + OCCUPANCY_WORDS - sliceStride, neighborLayer.data(), sliceStride);
+                } else {
+                    std::copy(solid + OCCUPANCY_WORDS - sliceStride, solid + OCCUPANCY_WORDS, &out[OCCUPANCY_WORDS - sliceStride]);
+                }
+                break;
+            case 5: // Back (-Z)
+                if (hasLayer) {
+                    OccupancyKernels::andNot(out.data(), solid, neighborLayer.data(), sliceStride);
+                } else {
+                    std::copy(solid, solid + sliceStride, out.data());
+                }
+                OccupancyKernels::andNot(&out[sliceStride], solid + sliceStride, solid, OCCUPANCY_WORDS - sliceStride);
+                break;
+        }
+    }
+
+    // Solid voxels with at least one exposed face, in occupancy layout.
+    // Chunk-local: voxels on the chunk border always count as exposed, so the
+    // result (used for physics) only depends on this chunk's own contents.
+    void computeSurfaceMask(std::vector<uint64_t>& out) const {
+        out.assign(OCCUPANCY_WORDS, 0);
+        if (occupancy.empty()) return;
+
+        std::vector<uint64_t> faceMask;
+        for (int face = 0; face < 6; ++face) {
+            computeFaceMask(face, faceMask);
+            OccupancyKernels::orInto(out.data(), faceMask.data(), OCCUPANCY_WORDS);
+        }
+    }
+
+    // Call fn(x, y, z) for every set bit of an occupancy-layout mask
+    template <typename Fn>
+    static void forEachSetBit(const std::vector<uint64_t>& mask, Fn&& fn) {
+        for (size_t w = 0; w < mask.size(); ++w) {
+            uint64_t bits = mask[w];
+            if (bits == 0) continue;
+            int row = static_cast<int>(w / WORDS_PER_ROW);
+            int xBase = static_cast<int>(w % WORDS_PER_ROW) * 64;
+            int y = row % CHUNK_SIZE;
+            int z = row / CHUNK_SIZE;
+            while (bits) {
+                int bit = std::countr_zero(bits);
+                fn(xBase + bit, y, z);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Call fn(x, y, z) for every surface voxel
+    template <typename Fn>
+    void forEachSurfaceVoxel(Fn&& fn) const {
+        if (occupancy.empty()) return;
+        std::vector<uint64_t> surface;
+        computeSurfaceMask(surface);
+        forEachSetBit(surface, fn);
+    }
     
     
-    // Rebuild mesh with greedy meshing
+    // Facing border layers of the six loaded neighbors (empty where there is none)
+    using NeighborLayers = std::array<std::vector<uint64_t>, 6>;
+
+    NeighborLayers gatherNeighborLayers() const {
+        NeighborLayers layers;
+        for (int face = 0; face < 6; ++face) {
+            if (neighbors[face]) layers[face] = neighbors[face]->extractBorderLayer(face ^ 1);
+        }
+        return layers;
+    }
+
+    // Copy of the voxel storage only (no mesh, no neighbor links), safe to mesh on
+    // another thread while this chunk keeps being edited
+    std::unique_ptr<Chunk> createSnapshot() const {
+        auto snapshot = std::make_unique<Chunk>(coordinate);
+        snapshot->palette = palette;
+        snapshot->paletteRefCounts = paletteRefCounts;
+        snapshot->paletteLookup = paletteLookup;
+        snapshot->freePaletteSlots = freePaletteSlots;
+        snapshot->bricks = bricks;
+        snapshot->indexBits = indexBits;
+        snapshot->occupancy = occupancy;
+        snapshot->isEmpty = isEmpty;
+        return snapshot;
+    }
+
+    // Rebuild the dirty sections with greedy meshing on the calling thread
     void rebuildMesh() {
-        if (!meshDirty) return;
+        uint64_t sections = takeDirtySections();
+        if (!sections) return;
+        buildMesh(gatherNeighborLayers(), sections);
+        uploadPendingSections |= sections;
+    }
+
+    // Exchange section meshes with the caller, e.g. to install meshes built from a
+    // snapshot. meshes holds one entry per set bit of sections, lowest bit first.
+    // Patched sections are skipped; returns the sections actually swapped.
+    uint64_t swapSectionMeshes(uint64_t sections, std::vector<SectionMesh>& meshes) {
+        uint64_t swapped = 0;
+        size_t i = 0;
+        for (uint64_t bits = sections; bits; bits &= bits - 1) {
+            int section = std::countr_zero(bits);
+            if (!isSectionPatched(section)) {
+                std::swap(sectionMeshes[section], meshes[i]);
+                swapped |= 1ull << section;
+            }
+            ++i;
+        }
+        return swapped;
+    }
+
+    // Greedy-mesh the given sections from the current voxels. Touches nothing but
+    // this chunk's own storage; neighbor occupancy comes in through layers.
+    void buildMesh(const NeighborLayers& layers, uint64_t sections) {
+        for (uint64_t bits = sections; bits; bits &= bits - 1) {
+            sectionMeshes[std::countr_zero(bits)].clear();
+        }
         
-        vertexCache.clear();
-        indexCache.clear();
+        if (isEmpty || !sections) return;
         
-        if (isEmpty) {
-            meshDirty = false;
-            return;
+        // Faces merge when they share color and texture, so map every palette entry
+        // to the first referenced entry with the same look
+        std::vector<int32_t> mergeKeys(palette.size());
+        FlatHashMap<VoxelData, int32_t, VoxelDataHash> firstWithLook;
+        for (size_t p = 0; p < palette.size(); ++p) {
+            mergeKeys[p] = static_cast<int32_t>(p);
+            if (p == 0 || paletteRefCounts[p] == 0) continue;
+            VoxelData look(palette[p].color, 1, palette[p].textureId);
+            mergeKeys[p] = firstWithLook.try_emplace(look, static_cast<int32_t>(p)).first->second;
         }
         
-        glm::vec3 worldPos = getWorldPosition();
-        
-        // Simple face culling - only render faces exposed to air
-        for (int x = 0; x < CHUNK_SIZE; ++x) {
-            for (int y = 0; y < CHUNK_SIZE; ++y) {
-                for (int z = 0; z < CHUNK_SIZE; ++z) {
-                    if (!isSolid(x, y, z)) continue;
-                    
-                    const VoxelData& voxel = getVoxel(x, y, z);
-                    glm::vec3 pos = worldPos + glm::vec3(x, y, z) * VOXEL_SIZE;
-                    
-                    // Add debug check:
-                    if (std::isnan(pos.x) || std::isnan(pos.y) || std::isnan(pos.z)) {
-                        continue; // Skip invalid positions
+        // Only faces exposed to air are meshed; visibility for a whole direction is
+        // computed word-wide from the occupancy mask. Each section is then swept slice
+        // by slice along the face normal, merging coplanar faces into maximal rectangles
+        // that never cross the section boundary.
+        // Within a slice the plane is indexed by (a, b): for Y faces a = x, b = z;
+        // for X faces a = y, b = z; for Z faces a = x, b = y.
+        // Faces on the chunk border are culled against the loaded neighbor's facing layer.
+        std::vector<uint64_t> faceMask;
+        std::vector<std::vector<uint32_t>> sliceFaces(SECTION_SIZE);
+        std::vector<int32_t> plane(CHUNK_SIZE * CHUNK_SIZE, -1);
+        for (int face = 0; face < 6; ++face) {
+            int normalAxis = (face < 2) ? 1 : (face < 4) ? 0 : 2;
+            auto toVoxel = [normalAxis](int slice, int a, int b) {
+                if (normalAxis == 1) return glm::ivec3(a, slice, b);
+                if (normalAxis == 0) return glm::ivec3(slice, a, b);
+                return glm::ivec3(a, b, slice);
+            };
+
+            computeFaceMask(face, faceMask, layers[face]);
+            for (uint64_t bits = sections; bits; bits &= bits - 1) {
+                int section = std::countr_zero(bits);
+                SectionMesh& mesh = sectionMeshes[section];
+                glm::ivec3 lo = sectionOrigin(section);
+                int sliceStart = lo[normalAxis];
+                int aEnd = (normalAxis == 0 ? lo.y : lo.x) + SECTION_SIZE;
+                int bEnd = (normalAxis == 2 ? lo.y : lo.z) + SECTION_SIZE;
+
+                // Collect the section's faces in (b, a) scan order within each slice
+                for (auto& faces : sliceFaces) faces.clear();
+                constexpr uint64_t rowBits = (SECTION_SIZE == 64) ? ~0ull : ((1ull << SECTION_SIZE) - 1);
+                for (int z = lo.z; z < lo.z + SECTION_SIZE; ++z) {
+                    for (int y = lo.y; y < lo.y + SECTION_SIZE; ++y) {
+                        uint64_t row = (faceMask[occupancyWordIndex(lo.x, y, z)] >> (lo.x & 63)) & rowBits;
+                        while (row) {
+                            int x = lo.x + std::countr_zero(row);
+                            row &= row - 1;
+                            if (normalAxis == 1) sliceFaces[y - sliceStart].push_back(x + z * CHUNK_SIZE);
+                            else if (normalAxis == 0) sliceFaces[x - sliceStart].push_back(y + z * CHUNK_SIZE);
+                            else sliceFaces[z - sliceStart].push_back(x + y * CHUNK_SIZE);
+                        }
+                    }
+                }
+
+                for (int localSlice = 0; localSlice < SECTION_SIZE; ++localSlice) {
+                    const std::vector<uint32_t>& faces = sliceFaces[localSlice];
+                    if (faces.empty()) continue;
+                    int slice = sliceStart + localSlice;
+
+                    for (uint32_t cell : faces) {
+                        glm::ivec3 v = toVoxel(slice, cell % CHUNK_SIZE, cell / CHUNK_SIZE);
+                        plane[cell] = mergeKeys[paletteIndexAt(v.x, v.y, v.z)];
                     }
 
-                    // Check each face
-                    if (!isSolid(x, y + 1, z)) addFace(pos, voxel.color, voxel.textureId, 0); // Top
-                    if (!isSolid(x, y - 1, z)) addFace(pos, voxel.color, voxel.textureId, 1); // Bottom
-                    if (!isSolid(x + 1, y, z)) addFace(pos, voxel.color, voxel.textureId, 2); // Right
-                    if (!isSolid(x - 1, y, z)) addFace(pos, voxel.color, voxel.textureId, 3); // Left
-                    if (!isSolid(x, y, z + 1)) addFace(pos, voxel.color, voxel.textureId, 4); // Front
-                    if (!isSolid(x, y, z - 1)) addFace(pos, voxel.color, voxel.textureId, 5); // Back
-
-                    // if (!isSolid(x, y + 1, z)) addDoubleSidedFace(pos, voxel.color, 0); // Top
-                    // if (!isSolid(x, y - 1, z)) addDoubleSidedFace(pos, voxel.color, 1); // Bottom
-                    // if (!isSolid(x + 1, y, z)) addDoubleSidedFace(pos, voxel.color, 2); // Right
-                    // if (!isSolid(x - 1, y, z)) addDoubleSidedFace(pos, voxel.color, 3); // Left
-                    // if (!isSolid(x, y, z + 1)) addDoubleSidedFace(pos, voxel.color, 4); // Front
-                    // if (!isSolid(x, y, z - 1)) addDoubleSidedFace(pos, voxel.color, 5); // Back
-
-                    // addCube(pos, voxel.color);
+                    for (uint32_t cell : faces) {
+                        int32_t key = plane[cell];
+                        if (key < 0) continue; // Already merged into an earlier quad
+                        int a = cell % CHUNK_SIZE;
+                        int b = cell / CHUNK_SIZE;
+
+                        int width = 1;
+                        while (a + width < aEnd && plane[cell + width] == key) ++width;
+
+                        int height = 1;
+                        while (b + height < bEnd) {
+                            int rowStart = cell + height * CHUNK_SIZE;
+                            bool rowMatches = true;
+                            for (int i = 0; i < width && rowMatches; ++i) {
+                                rowMatches = plane[rowStart + i] == key;
+                            }
+                            if (!rowMatches) break;
+                            ++height;
+                        }
+
+                        for (int j = 0; j < height; ++j) {
+                            std::fill_n(plane.begin() + cell + j * CHUNK_SIZE, width, -1);
+                        }
+
+                        glm::ivec3 origin = toVoxel(slice, a, b);
+                        glm::ivec3 size(1);
+                        if (normalAxis == 1) size = glm::ivec3(width, 1, height);
+                        else if (normalAxis == 0) size = glm::ivec3(1, width, height);
+                        else size = glm::ivec3(width, height, 1);
+
+                        const VoxelData& voxel = palette[paletteIndexAt(origin.x, origin.y, origin.z)];
+                        addFace(mesh, origin, size, voxel.color, voxel.textureId, face);
+                    }
                 }
             }
         }
-        
-        // meshDirty = false; // Moved to VulkanEngine::updateChunkBuffers
     }
     
-    const std::vector<Vertex>& getVertices() const { return vertexCache; }
-    const std::vector<uint32_t>& getIndices() const { return indexCache; }
-    bool isDirty() const { return meshDirty; }
+    const SectionMesh& getSectionMesh(int section) const { return sectionMeshes[section]; }
+
+    // World-space bounds of a section's geometry; false when it has none
+    bool getSectionBounds(int section, glm::vec3& outMin, glm::vec3& outMax) const {
+        const SectionMesh& mesh = sectionMeshes[section];
+        if (mesh.indices.empty()) return false;
+        glm::vec3 worldPos = getWorldPosition();
+        outMin = worldPos + glm::vec3(mesh.boundsMin) * VOXEL_SIZE;
+        outMax = worldPos + glm::vec3(mesh.boundsMax) * VOXEL_SIZE;
+        return true;
+    }
+
+    bool isDirty() const { return (dirtySections & ~patchedSections) != 0; }
+    void markDirty() { dirtySections = ALL_SECTIONS; }
+
+    // Return and clear the dirty sections, e.g. when handing them to a mesh job.
+    // Patched sections stay dirty until finishPatching.
+    uint64_t takeDirtySections() {
+        uint64_t sections = dirtySections & ~patchedSections;
+        if (!sections) return 0;
+
+        // Rebuilt sections are culled against what is linked now, so a recorded
+        // border no longer describes the whole side: remesh all of it
+        for (int face = 0; face < 6; ++face) {
+            if ((cachedBorderMask & (1u << face)) && (sections & borderSections(face))) {
+                cachedBorderMask &= ~(1u << face);
+                sections |= borderSections(face) & ~patchedSections;
+            }
+        }
+        dirtySections &= ~sections;
+        meshCacheStale = true;
+        return sections;
+    }
+
+    bool hasPendingUpload() const { return uploadPendingSections != 0; }
+    void markUploadPending(uint64_t sections) { uploadPendingSections |= sections; }
+
+    // Return and clear the sections whose meshes need uploading
+    uint64_t takePendingUploads() {
+        uint64_t sections = uploadPendingSections;
+        uploadPendingSections = 0;
+        return sections;
+    }
     bool empty() const { return isEmpty; }
     
-    // Binary serialization
-    void saveToBinary(std::ofstream& out) const {
-        // Write coordinate
-        out.write(reinterpret_cast<const char*>(&coordinate), sizeof(ChunkCoord));
-        
-        // Write isEmpty flag
-        out.write(reinterpret_cast<const char*>(&isEmpty), sizeof(bool));
-        
-        if (isEmpty) return; // Skip empty chunks
-        
-        // Write voxel data
-        out.write(reinterpret_cast<const char*>(voxels.data()), 
-                  voxels.size() * sizeof(VoxelData));
+    // Binary serialization. Chunk files are a header followed by the palette
+    // (referenced entries only) and each brick as a single index, index runs or
+    // packed indices, whichever is smallest. Files from before the header existed
+    // hold one raw VoxelData per voxel and are still read.
+    static constexpr uint32_t CHUNK_FILE_MAGIC = 0x4B435856; // "VXCK"
+    static constexpr uint32_t CHUNK_FILE_VERSION = 1;
+
+    // Whether encoded bytes are those of a chunk with no voxels, without decoding them
+    static bool isEmptyEncoding(const uint8_t* data, size_t size) {
+        constexpr size_t EMPTY_FLAG_OFFSET = 2 * sizeof(uint32_t) + sizeof(ChunkCoord);
+        uint32_t magic = 0, version = 0;
+        if (size <= EMPTY_FLAG_OFFSET) return false;
+        std::memcpy(&magic, data, sizeof(magic));
+        std::memcpy(&version, data + sizeof(magic), sizeof(version));
+        return magic == CHUNK_FILE_MAGIC && version == CHUNK_FILE_VERSION && data[EMPTY_FLAG_OFFSET] != 0;
     }
-    
-    bool loadFromBinary(std::ifstream& in) {
-        // Read coordinate
-        in.read(reinterpret_cast<char*>(&coordinate), sizeof(ChunkCoord));
+
+    void saveToBinary(std::ostream& out) const {
+        std::vector<uint8_t> bytes;
+        encode(bytes);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    bool loadFromBinary(std::istream& in) {
+        uint32_t magic = 0;
+        in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        if (!in.good()) return false;
+        if (magic == CHUNK_FILE_MAGIC) {
+            std::vector<uint8_t> bytes(sizeof(magic));
+            std::memcpy(bytes.data(), &magic, sizeof(magic));
+            bytes.insert(bytes.end(), std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            return decode(bytes.data(), bytes.size());
+        }
+        // Legacy files start with the coordinate; the word read was its x
+        std::memcpy(&coordinate.x, &magic, sizeof(magic));
+        return loadLegacy(in);
+    }
+
+    // Same as loadFromBinary for bytes already in memory, e.g. a region entry
+    bool loadFromMemory(const uint8_t* data, size_t size) {
+        uint32_t magic = 0;
+        if (size >= sizeof(magic)) std::memcpy(&magic, data, sizeof(magic));
+        if (magic == CHUNK_FILE_MAGIC) return decode(data, size);
+
+        MemoryStreamBuffer buffer(data, size);
+        std::istream in(&buffer);
+        return loadFromBinary(in);
+    }
+
+    // Sparse difference from baseline, the same chunk as generated: the changed
+    // voxel values, then each changed voxel as a gap from the previous one (in
+    // brick order) and an index into those values. Air matches air whatever its
+    // color. Returns false, leaving out partial, once the encoding would reach
+    // maxBytes, so callers can fall back to the full form.
+    bool encodeDelta(const Chunk& baseline, size_t maxBytes, std::vector<uint8_t>& out) const {
+        std::vector<VoxelData> values;
+        std::vector<uint32_t> positions;
+        std::vector<uint32_t> valueIndices;
+        for (int b = 0; b < BRICK_COUNT; ++b) {
+            const VoxelData* ours = uniformBrickVoxel(b);
+            const VoxelData* theirs = baseline.uniformBrickVoxel(b);
+            if (ours && theirs && looksSame(*ours, *theirs)) continue;
+
+            int bx = (b % BRICKS_PER_AXIS) * BRICK_SIZE;
+            int by = (b / BRICKS_PER_AXIS % BRICKS_PER_AXIS) * BRICK_SIZE;
+            int bz = (b / (BRICKS_PER_AXIS * BRICKS_PER_AXIS)) * BRICK_SIZE;
+            for (int local = 0; local < BRICK_VOLUME; ++local) {
+                int x = bx + local % BRICK_SIZE;
+                int y = by + local / BRICK_SIZE % BRICK_SIZE;
+                int z = bz + local / (BRICK_SIZE * BRICK_SIZE);
+                const VoxelData& voxel = getVoxel(x, y, z);
+                if (looksSame(voxel, baseline.getVoxel(x, y, z))) continue;
+
+                uint32_t value = 0;
+                while (value < values.size() && !looksSame(values[value], voxel)) ++value;
+                if (value == values.size()) values.push_back(voxel);
+                positions.push_back(static_cast<uint32_t>(b * BRICK_VOLUME + local));
+                valueIndices.push_back(value);
+                // Every change costs at least two bytes
+                if (values.size() * PALETTE_ENTRY_BYTES + positions.size() * 2 >= maxBytes) return false;
+            }
+        }
+
+        writeVarint(out, static_cast<uint32_t>(values.size()));
+        for (const VoxelData& voxel : values) writePaletteEntry(out, voxel);
+        writeVarint(out, static_cast<uint32_t>(positions.size()));
+        uint32_t previous = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            writeVarint(out, positions[i] - previous);
+            writeVarint(out, valueIndices[i]);
+            previous = positions[i];
+        }
+        return out.size() < maxBytes;
+    }
+
+    // Apply a delta from encodeDelta to this chunk, which must hold the baseline
+    // it was made against. Rejects truncated or out of range data.
+    bool applyDelta(const uint8_t* data, size_t size) {
+        ByteReader reader{data, data + size};
+        uint32_t valueCount = reader.varint();
+        if (reader.failed || size_t(reader.end - reader.data) < size_t(valueCount) * PALETTE_ENTRY_BYTES) return false;
+        std::vector<VoxelData> values(valueCount);
+        for (VoxelData& voxel : values) voxel = readPaletteEntry(reader);
+
+        uint32_t changeCount = reader.varint();
+        uint64_t position = 0;
+        for (uint32_t i = 0; i < changeCount; ++i) {
+            position += reader.varint();
+            uint32_t value = reader.varint();
+            if (reader.failed || position >= uint64_t(CHUNK_VOLUME) || value >= valueCount) return false;
+
+            int b = static_cast<int>(position / BRICK_VOLUME);
+            int local = static_cast<int>(position % BRICK_VOLUME);
+            setVoxel((b % BRICKS_PER_AXIS) * BRICK_SIZE + local % BRICK_SIZE,
+                     (b / BRICKS_PER_AXIS % BRICKS_PER_AXIS) * BRICK_SIZE + local / BRICK_SIZE % BRICK_SIZE,
+                     (b / (BRICKS_PER_AXIS * BRICKS_PER_AXIS)) * BRICK_SIZE + local / (BRICK_SIZE * BRICK_SIZE),
+                     values[value]);
+        }
+        if (reader.failed || reader.data != reader.end) return false;
+        compactBricks();
+        return true;
+    }
+
+    // Mesh cache entry: the section meshes plus the voxel content and neighbor
+    // borders they were built from. Indices are not stored; every quad uses the
+    // same 0,1,2 0,2,3 pattern.
+    struct MeshCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t contentHash;
+        uint64_t borderHashes[6];
+        uint32_t quadCounts[SECTION_COUNT];
+        int32_t bounds[SECTION_COUNT][6];
+    };
+    static constexpr uint32_t MESH_CACHE_MAGIC = 0x434D5856; // "VXMC"
+
+    // True when every section mesh is built from the current voxels
+    bool hasCompleteMeshes() const {
+        return !isEmpty && dirtySections == 0 && patchedSections == 0;
+    }
+
+    // True when the meshes are complete and newer than the mesh cache on disk
+    bool canSaveMeshCache() const {
+        return meshCacheStale && hasCompleteMeshes();
+    }
+
+    bool saveMeshCache(std::ostream& out) {
+        MeshCacheHeader header{};
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        header.contentHash = contentHash();
+        for (int face = 0; face < 6; ++face) {
+            if (cachedBorderMask & (1u << face)) {
+                header.borderHashes[face] = cachedBorderHashes[face];
+            } else {
+                header.borderHashes[face] = hashLayer(neighbors[face] ? neighbors[face]->extractBorderLayer(face ^ 1) : std::vector<uint64_t>());
+            }
+        }
+        for (int section = 0; section < SECTION_COUNT; ++section) {
+            const SectionMesh& mesh = sectionMeshes[section];
+            header.quadCounts[section] = static_cast<uint32_t>(mesh.vertices.size() / 4);
+            const int32_t bounds[6] = {mesh.boundsMin.x, mesh.boundsMin.y, mesh.boundsMin.z, mesh.boundsMax.x, mesh.boundsMax.y, mesh.boundsMax.z};
+            std::copy(bounds, bounds + 6, header.bounds[section]);
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const SectionMesh& mesh : sectionMeshes) {
+            out.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(VoxelVertex));
+        }
+        if (!out.good()) return false;
+        meshCacheStale = false;
+        return true;
+    }
+
+    // Replace the section meshes with cached ones if the entry was built from the
+    // current voxels. Border sections facing a linked neighbor whose border changed
+    // are marked dirty; unlinked sides are checked when their neighbor links.
+    bool loadMeshCache(const uint8_t* cacheData, size_t cacheSize) {
+        if (!cacheData || cacheSize < sizeof(MeshCacheHeader)) return false;
+
+        MeshCacheHeader header;
+        std::memcpy(&header, cacheData, sizeof(header));
+        if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION) return false;
+
+        size_t expectedSize = sizeof(header);
+        for (uint32_t quads : header.quadCounts) expectedSize += size_t(quads) * 4 * sizeof(VoxelVertex);
+        if (cacheSize != expectedSize || header.contentHash != contentHash()) return false;
+
+        const uint8_t* data = cacheData + sizeof(header);
+        for (int section = 0; section < SECTION_COUNT; ++section) {
+            SectionMesh& mesh = sectionMeshes[section];
+            uint32_t quads = header.quadCounts[section];
+            mesh.vertices.resize(size_t(quads) * 4);
+            std::memcpy(mesh.vertices.data(), data, mesh.vertices.size() * sizeof(VoxelVertex));
+            data += mesh.vertices.size() * sizeof(VoxelVertex);
+
+            mesh.indices.resize(size_t(quads) * 6);
+            for (uint32_t quad = 0; quad < quads; ++quad) {
+                uint32_t base = quad * 4;
+                uint32_t* indices = &mesh.indices[size_t(quad) * 6];
+                indices[0] = base + 0; indices[1] = base + 1; indices[2] = base + 2;
+                indices[3] = base + 0; indices[4] = base + 2; indices[5] = base + 3;
+            }
+            const int32_t* bounds = header.bounds[section];
+            mesh.boundsMin = glm::ivec3(bounds[0], bounds[1], bounds[2]);
+            mesh.boundsMax = glm::ivec3(bounds[3], bounds[4], bounds[5]);
+        }
+
+        dirtySections = 0;
+        uploadPendingSections = ALL_SECTIONS;
+        meshCacheStale = false;
+        cachedBorderMask = 0;
+        for (int face = 0; face < 6; ++face) {
+            if (neighbors[face]) {
+                if (header.borderHashes[face] != hashLayer(neighbors[face]->extractBorderLayer(face ^ 1))) {
+                    dirtySections |= borderSections(face);
+                }
+            } else {
+                cachedBorderHashes[face] = header.borderHashes[face];
+                cachedBorderMask |= 1u << face;
+            }
+        }
+        return true;
+    }
+
+    // Hash of everything buildMesh reads from this chunk: which voxels are solid and
+    // the color and texture of each. Independent of palette order and brick layout,
+    // so the same voxels hash the same after a save and reload.
+    uint64_t contentHash() const {
+        uint64_t hash = mixHash(0, MESH_CACHE_VERSION);
+        if (isEmpty || bricks.empty()) return hash;
+
+        // Air hashes to 0 whatever its color
+        std::vector<uint64_t> looks(palette.size(), 0);
+        for (size_t p = 0; p < palette.size(); ++p) {
+            const VoxelData& voxel = palette[p];
+            if (voxel.type == 0) continue;
+            uint32_t channels[4];
+            std::memcpy(channels, &voxel.color, sizeof(channels));
+            uint64_t look = mixHash(static_cast<uint64_t>(voxel.textureId) + 1, channels[0]);
+            look = mixHash(look, channels[1]);
+            look = mixHash(look, channels[2]);
+            look = mixHash(look, channels[3]);
+            looks[p] = look | 1;
+        }
+
+        for (const Brick& brick : bricks) {
+            if (brick.isUniform()) {
+                hash = mixHash(hash, looks[brick.uniformIndex]);
+                continue;
+            }
+            // A materialized brick whose voxels all look alike hashes like a uniform one
+            uint64_t first = looks[brick.indices.get(0)];
+            uint64_t brickHash = 0;
+            bool uniform = true;
+            for (int i = 0; i < BRICK_VOLUME; ++i) {
+                uint64_t look = looks[brick.indices.get(i)];
+                uniform = uniform && look == first;
+                brickHash = mixHash(brickHash, look);
+            }
+            hash = mixHash(hash, uniform ? first : brickHash);
+        }
+        return hash;
+    }
+
+    static uint64_t hashLayer(const std::vector<uint64_t>& layer) {
+        uint64_t hash = mixHash(0, layer.size());
+        for (uint64_t word : layer) hash = mixHash(hash, word);
+        return hash;
+    }
+
+private:
+    static constexpr int SERIALIZATION_BATCH = CHUNK_SIZE * CHUNK_SIZE;
+
+    // Brick encodings in chunk files
+    enum BrickEncoding : uint8_t { BRICK_UNIFORM = 0, BRICK_RUNS = 1, BRICK_PACKED = 2 };
+    static constexpr size_t PALETTE_ENTRY_BYTES = 4 * sizeof(float) + sizeof(uint8_t) + sizeof(int32_t);
+
+    // Read-only streambuf over a byte range, so the legacy reader can parse memory
+    struct MemoryStreamBuffer : std::streambuf {
+        MemoryStreamBuffer(const uint8_t* data, size_t size) {
+            char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+            setg(begin, begin, begin + size);
+        }
+    };
+
+    static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <typename T>
+    static void writeRaw(std::vector<uint8_t>& out, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Bounds-checked cursor over an encoded chunk; any overrun sets failed
+    struct ByteReader {
+        const uint8_t* data;
+        const uint8_t* end;
+        bool failed = false;
+
+        template <typename T>
+        T raw() {
+            T value{};
+            if (size_t(end - data) < sizeof(T)) {
+                failed = true;
+                return value;
+            }
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return value;
+        }
+
+        uint32_t varint() {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                if (data == end) break;
+                uint8_t byte = *data++;
+                value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+            failed = true;
+            return 0;
+        }
+    };
+
+    static void writePaletteEntry(std::vector<uint8_t>& out, const VoxelData& voxel) {
+        writeRaw(out, voxel.color.r);
+        writeRaw(out, voxel.color.g);
+        writeRaw(out, voxel.color.b);
+        writeRaw(out, voxel.color.a);
+        writeRaw(out, voxel.type);
+        writeRaw(out, static_cast<int32_t>(voxel.textureId));
+    }
+
+    static VoxelData readPaletteEntry(ByteReader& reader) {
+        VoxelData voxel;
+        voxel.color.r = reader.raw<float>();
+        voxel.color.g = reader.raw<float>();
+        voxel.color.b = reader.raw<float>();
+        voxel.color.a = reader.raw<float>();
+        voxel.type = reader.raw<uint8_t>();
+        voxel.textureId = reader.raw<int32_t>();
+        return voxel;
+    }
+
+    // Equal as far as anything reading the chunk can tell: air is air whatever its color
+    static bool looksSame(const VoxelData& a, const VoxelData& b) {
+        return (a.type == 0 && b.type == 0) || a == b;
+    }
+
+    // The value filling a brick if it holds a single index, else null
+    const VoxelData* uniformBrickVoxel(int b) const {
+        if (bricks.empty()) return &palette[0];
+        const Brick& brick = bricks[b];
+        return brick.isUniform() ? &palette[brick.uniformIndex] : nullptr;
+    }
+
+    void encode(std::vector<uint8_t>& out) const {
+        writeRaw(out, CHUNK_FILE_MAGIC);
+        writeRaw(out, CHUNK_FILE_VERSION);
+        writeRaw(out, coordinate);
+        writeRaw(out, static_cast<uint8_t>(isEmpty ? 1 : 0));
+        if (isEmpty) return;
+
+        // Renumber the referenced entries densely; air stays 0
+        std::vector<uint32_t> remap(palette.size(), 0);
+        std::vector<uint32_t> used(1, 0);
+        for (uint32_t p = 1; p < palette.size(); ++p) {
+            if (paletteRefCounts[p] == 0 || palette[p].type == 0) continue;
+            remap[p] = static_cast<uint32_t>(used.size());
+            used.push_back(p);
+        }
+        writeVarint(out, static_cast<uint32_t>(used.size()));
+        for (uint32_t p : used) writePaletteEntry(out, palette[p]);
+
+        writeRaw(out, static_cast<uint8_t>(bricks.empty() ? 0 : 1));
+        if (bricks.empty()) return;
+
+        int fileBits = BitPackedArray::bitsForValue(static_cast<uint32_t>(used.size() - 1));
+        std::vector<uint8_t> runs;
+        BitPackedArray packed(BRICK_VOLUME, fileBits);
+        for (const Brick& brick : bricks) {
+            if (brick.isUniform()) {
+                out.push_back(BRICK_UNIFORM);
+                writeVarint(out, remap[brick.uniformIndex]);
+                continue;
+            }
+
+            runs.clear();
+            int runCount = 0;
+            uint32_t value = remap[brick.indices.get(0)];
+            uint32_t length = 1;
+            for (int i = 1; i <= BRICK_VOLUME; ++i) {
+                uint32_t next = (i < BRICK_VOLUME) ? remap[brick.indices.get(i)] : UINT32_MAX;
+                if (next == value) {
+                    ++length;
+                    continue;
+                }
+                writeVarint(runs, length);
+                writeVarint(runs, value);
+                ++runCount;
+                value = next;
+                length = 1;
+            }
+
+            if (runCount == 1) {
+                // Edits left the brick holding a single value
+                out.push_back(BRICK_UNIFORM);
+                writeVarint(out, remap[brick.indices.get(0)]);
+            } else if (runs.size() < packed.memoryUsage()) {
+                out.push_back(BRICK_RUNS);
+                writeVarint(out, static_cast<uint32_t>(runCount));
+                out.insert(out.end(), runs.begin(), runs.end());
+            } else {
+                for (int i = 0; i < BRICK_VOLUME; ++i) packed.set(i, remap[brick.indices.get(i)]);
+                out.push_back(BRICK_PACKED);
+                const uint8_t* words = reinterpret_cast<const uint8_t*>(packed.data().data());
+                out.insert(out.end(), words, words + packed.memoryUsage());
+            }
+        }
+    }
+
+    // Decode straight into palette, bricks and occupancy. Rejects truncated or
+    // inconsistent data instead of trusting counts from the file.
+    bool decode(const uint8_t* data, size_t size) {
+        ByteReader reader{data, data + size};
+        reader.raw<uint32_t>(); // Magic, checked by the caller
+        if (reader.raw<uint32_t>() != CHUNK_FILE_VERSION) return false;
+        coordinate = reader.raw<ChunkCoord>();
+        isEmpty = reader.raw<uint8_t>() != 0;
+        resetStorage();
+        dirtySections = ALL_SECTIONS;
+        if (reader.failed) return false;
+        if (isEmpty) return true;
+
+        uint32_t paletteCount = reader.varint();
+        if (paletteCount == 0 || paletteCount > uint32_t(CHUNK_VOLUME) + 1 ||
+            size_t(reader.end - reader.data) < size_t(paletteCount) * PALETTE_ENTRY_BYTES) return false;
+        palette.resize(paletteCount);
+        for (VoxelData& voxel : palette) voxel = readPaletteEntry(reader);
+        if (palette[0].type != 0) return false;
+        indexBits = BitPackedArray::bitsForValue(paletteCount - 1);
+        paletteRefCounts.assign(paletteCount, 0);
+        paletteRefCounts[0] = CHUNK_VOLUME;
+
+        bool hasBricks = reader.raw<uint8_t>() != 0;
+        if (reader.failed) return false;
+        if (!hasBricks) return indexPalette();
+
+        paletteRefCounts[0] = 0;
+        bricks.assign(BRICK_COUNT, Brick());
+        occupancy.assign(OCCUPANCY_WORDS, 0);
+        size_t packedBytes = BitPackedArray(BRICK_VOLUME, indexBits).memoryUsage();
+        for (int b = 0; b < BRICK_COUNT; ++b) {
+            Brick& brick = bricks[b];
+            uint8_t encoding = reader.raw<uint8_t>();
+            if (encoding == BRICK_UNIFORM) {
+                uint32_t index = reader.varint();
+                if (index >= paletteCount) return false;
+                brick.uniformIndex = index;
+                paletteRefCounts[index] += BRICK_VOLUME;
+                if (palette[index].type != 0) markOccupied(b, 0, BRICK_VOLUME);
+            } else if (encoding == BRICK_RUNS) {
+                brick.indices = BitPackedArray(BRICK_VOLUME, indexBits);
+                uint32_t runCount = reader.varint();
+                uint32_t position = 0;
+                for (uint32_t r = 0; r < runCount && !reader.failed; ++r) {
+                    uint32_t length = reader.varint();
+                    uint32_t index = reader.varint();
+                    if (index >= paletteCount || length > BRICK_VOLUME - position) return false;
+                    for (uint32_t i = position; i < position + length; ++i) brick.indices.set(i, index);
+                    paletteRefCounts[index] += length;
+                    if (palette[index].type != 0) markOccupied(b, position, length);
+                    position += length;
+                }
+                if (position != BRICK_VOLUME) return false;
+            } else if (encoding == BRICK_PACKED) {
+                if (size_t(reader.end - reader.data) < packedBytes) return false;
+                brick.indices = BitPackedArray(BRICK_VOLUME, indexBits);
+                std::memcpy(brick.indices.data().data(), reader.data, packedBytes);
+                reader.data += packedBytes;
+                for (int i = 0; i < BRICK_VOLUME; ++i) {
+                    uint32_t index = brick.indices.get(i);
+                    if (index >= paletteCount) return false;
+                    ++paletteRefCounts[index];
+                    if (palette[index].type != 0) markOccupied(b, i, 1);
+                }
+            } else {
+                return false;
+            }
+            if (reader.failed) return false;
+        }
+        compactBricks();
+        return indexPalette();
+    }
+
+    // Rebuild the palette lookup and free slots from freshly decoded entries
+    bool indexPalette() {
+        for (uint32_t p = 1; p < palette.size(); ++p) {
+            if (paletteRefCounts[p] == 0) {
+                freePaletteSlots.push_back(p);
+            } else if (palette[p].type != 0) {
+                paletteLookup.try_emplace(palette[p], p);
+            }
+        }
+        return true;
+    }
+
+    // Set occupancy bits for count voxels of a brick starting at a local index,
+    // a row segment at a time
+    void markOccupied(int brickIndex, uint32_t local, uint32_t count) {
+        int bx = (brickIndex % BRICKS_PER_AXIS) * BRICK_SIZE;
+        int by = ((brickIndex / BRICKS_PER_AXIS) % BRICKS_PER_AXIS) * BRICK_SIZE;
+        int bz = (brickIndex / (BRICKS_PER_AXIS * BRICKS_PER_AXIS)) * BRICK_SIZE;
+        while (count > 0) {
+            int lx = local % BRICK_SIZE;
+            int ly = (local / BRICK_SIZE) % BRICK_SIZE;
+            int lz = local / (BRICK_SIZE * BRICK_SIZE);
+            uint32_t span = std::min<uint32_t>(count, BRICK_SIZE - lx);
+            int x = bx + lx;
+            uint64_t bits = ((1ull << span) - 1) << (x & 63);
+            occupancy[occupancyWordIndex(x, by + ly, bz + lz)] |= bits;
+            local += span;
+            count -= span;
+        }
+    }
+
+    // Reader for files written before CHUNK_FILE_MAGIC; coordinate.x is already read
+    bool loadLegacy(std::istream& in) {
+        in.read(reinterpret_cast<char*>(&coordinate.y), sizeof(int));
+        in.read(reinterpret_cast<char*>(&coordinate.z), sizeof(int));
         
         // Read isEmpty flag
         in.read(reinterpret_cast<char*>(&isEmpty), sizeof(bool));
         
+        resetStorage();
+        dirtySections = ALL_SECTIONS;
         if (isEmpty) {
-            voxels.clear();
-            voxels.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-            return true;
+            return in.good();
         }
         
-        // Read voxel data
-        voxels.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-        in.read(reinterpret_cast<char*>(voxels.data()), 
-                voxels.size() * sizeof(VoxelData));
-        
-        meshDirty = true;
+        // Read voxel data one z-slice at a time, folding each value into the palette
+        std::vector<VoxelData> batch(SERIALIZATION_BATCH);
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            in.read(reinterpret_cast<char*>(batch.data()), 
+                    batch.size() * sizeof(VoxelData));
+            if (!in.good()) return false;
+            for (int i = 0; i < SERIALIZATION_BATCH; ++i) {
+                setPaletteIndex(i % CHUNK_SIZE, i / CHUNK_SIZE, z, findOrAddPaletteEntry(batch[i]));
+            }
+        }
+        compactBricks();
         return in.good();
     }
 
-private:
-    void addCube(const glm::vec3& pos, const glm::vec4& color) {
-        float w = VOXEL_SIZE;
-        float h = VOXEL_SIZE;
-        float d = VOXEL_SIZE;
-        float hw = w / 2.0f; // half width
-        float hh = h / 2.0f; // half height
-        float hd = d / 2.0f; // half depth
-
-        // Define the 8 cube corners (local positions)
-        glm::vec3 localPositions[8] = {
-            glm::vec3(-hw, -hh,  hd), // 0 Front-bottom-left
-            glm::vec3( hw, -hh,  hd), // 1 Front-bottom-right
-            glm::vec3( hw,  hh,  hd), // 2 Front-top-right
-            glm::vec3(-hw,  hh,  hd), // 3 Front-top-left
-            glm::vec3(-hw, -hh, -hd), // 4 Back-bottom-left
-            glm::vec3( hw, -hh, -hd), // 5 Back-bottom-right
-            glm::vec3( hw,  hh, -hd), // 6 Back-top-right
-            glm::vec3(-hw,  hh, -hd)  // 7 Back-top-left
-        };
-
-        // Transform to world position
-        glm::vec3 positions[8];
-        for (int i = 0; i < 8; ++i) {
-            positions[i] = pos + localPositions[i];
-        }
-
-        // Define faces with indices and normals
-        struct Face {
-            int indices[6];
-            glm::vec3 normal;
-        };
-
-        Face faces[6] = {
-            {{0, 1, 2, 0, 2, 3}, glm::vec3( 0,  0,  1)}, // Front
-            {{5, 4, 7, 5, 7, 6}, glm::vec3( 0,  0, -1)}, // Back
-            {{3, 2, 6, 3, 6, 7}, glm::vec3( 0,  1,  0)}, // Top
-            {{4, 5, 1, 4, 1, 0}, glm::vec3( 0, -1,  0)}, // Bottom
-            {{1, 5, 6, 1, 6, 2}, glm::vec3( 1,  0,  0)}, // Right
-            {{4, 0, 3, 4, 3, 7}, glm::vec3(-1,  0,  0)}  // Left
-        };
-
-        // Build geometry for all faces
-        for (int faceIdx = 0; faceIdx < 6; ++faceIdx) {
-            const Face& face = faces[faceIdx];
-            uint32_t startIndex = static_cast<uint32_t>(vertexCache.size());
-
-            // Add 6 vertices (2 triangles per face)
-            for (int i = 0; i < 6; ++i) {
-                int idx = face.indices[i];
-                glm::vec3 p = positions[idx];
-                
-                Vertex v;
-                v.position = p;
-                // Assign texture coordinates based on vertex index for a full texture map per face
-                if (i == 0 || i == 3) v.texCoords = glm::vec2(0.0f, 0.0f);
-                else if (i == 1 || i == 4) v.texCoords = glm::vec2(1.0f, 0.0f);
-                else if (i == 2 || i == 5) v.texCoords = glm::vec2(1.0f, 1.0f);
-                v.color = color;
-                v.gradientCoords = glm::vec2((p.x - pos.x + hw) / w, (p.y - pos.y + hh) / h);
-                v.objectType = 6.0f; // 6 = solid voxel
-                v.normal = face.normal;
-                vertexCache.push_back(v);
+    static uint64_t mixHash(uint64_t hash, uint64_t value) {
+        hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+        hash *= 0xBF58476D1CE4E5B9ull;
+        return hash ^ (hash >> 31);
+    }
+
+    // Reset to an all-air chunk with a palette holding only air
+    void resetStorage() {
+        palette.assign(1, VoxelData());
+        paletteRefCounts.assign(1, CHUNK_VOLUME);
+        paletteLookup.clear();
+        freePaletteSlots.clear();
+        bricks.clear();
+        indexBits = 0;
+        lastPaletteLookup = 0;
+        occupancy.clear();
+    }
+
+    static int occupancyWordIndex(int x, int y, int z) {
+        return (y + z * CHUNK_SIZE) * WORDS_PER_ROW + (x >> 6);
+    }
+
+    static int brickIndexOf(int x, int y, int z) {
+        return (x / BRICK_SIZE) + (y / BRICK_SIZE) * BRICKS_PER_AXIS + (z / BRICK_SIZE) * BRICKS_PER_AXIS * BRICKS_PER_AXIS;
+    }
+
+    static int localIndexOf(int x, int y, int z) {
+        return (x % BRICK_SIZE) + (y % BRICK_SIZE) * BRICK_SIZE + (z % BRICK_SIZE) * BRICK_SIZE * BRICK_SIZE;
+    }
+
+    // Palette index of an in-range voxel
+    uint32_t paletteIndexAt(int x, int y, int z) const {
+        if (bricks.empty()) return 0;
+        const Brick& brick = bricks[brickIndexOf(x, y, z)];
+        if (brick.isUniform()) return brick.uniformIndex;
+        return brick.indices.get(localIndexOf(x, y, z));
+    }
+
+    // Palette index for a voxel value, adding it (and widening the indices) if needed.
+    // Every air voxel maps to entry 0 regardless of its color.
+    uint32_t findOrAddPaletteEntry(const VoxelData& data) {
+        if (data.type == 0) return 0;
+        if (lastPaletteLookup < palette.size() && palette[lastPaletteLookup] == data) {
+            return lastPaletteLookup;
+        }
+
+        auto it = paletteLookup.find(data);
+        if (it != paletteLookup.end()) {
+            lastPaletteLookup = it->second;
+            return it->second;
+        }
+
+        uint32_t index;
+        if (!freePaletteSlots.empty()) {
+            index = freePaletteSlots.back();
+            freePaletteSlots.pop_back();
+            palette[index] = data;
+        } else {
+            // Entries are only added while none is free, so every one but the
+            // voxel's current value is referenced and 32-bit indices always suffice
+            index = static_cast<uint32_t>(palette.size());
+            assert(index <= uint32_t(CHUNK_VOLUME) + 1);
+            palette.push_back(data);
+            paletteRefCounts.push_back(0);
+            int neededBits = BitPackedArray::bitsForValue(index);
+            if (neededBits > indexBits) {
+                indexBits = neededBits;
+                for (Brick& brick : bricks) {
+                    if (!brick.isUniform()) brick.indices.setBitsPerEntry(indexBits);
+                }
+            }
+        }
+        paletteLookup[data] = index;
+        lastPaletteLookup = index;
+        return index;
+    }
+
+    // Switch a section to unit quads, one per visible face, indexed for patching
+    void beginPatching(int section) {
+        if (isSectionPatched(section)) return;
+
+        SectionMesh& mesh = sectionMeshes[section];
+        mesh.clear();
+        auto patch = std::make_unique<SectionPatch>();
+
+        glm::ivec3 lo = sectionOrigin(section);
+        if (!occupancy.empty()) {
+            constexpr uint64_t rowBits = (SECTION_SIZE == 64) ? ~0ull : ((1ull << SECTION_SIZE) - 1);
+            for (int z = lo.z; z < lo.z + SECTION_SIZE; ++z) {
+                for (int y = lo.y; y < lo.y + SECTION_SIZE; ++y) {
+                    uint64_t row = (occupancy[occupancyWordIndex(lo.x, y, z)] >> (lo.x & 63)) & rowBits;
+                    while (row) {
+                        int x = lo.x + std::countr_zero(row);
+                        row &= row - 1;
+                        const VoxelData& voxel = palette[paletteIndexAt(x, y, z)];
+                        for (int face = 0; face < 6; ++face) {
+                            if (!isFaceExposed(x, y, z, face)) continue;
+                            uint32_t quad = static_cast<uint32_t>(mesh.vertices.size() / 4);
+                            writeFace(mesh, quad, glm::ivec3(x, y, z), glm::ivec3(1), voxel.color, voxel.textureId, face);
+                            patch->faceToQuad[patchKey(x, y, z, face)] = quad;
+                        }
+                    }
+                }
             }
+        }
 
-            // Add indices (already in the correct order from face.indices)
-            indexCache.push_back(startIndex + 0);
-            indexCache.push_back(startIndex + 1);
-            indexCache.push_back(startIndex + 2);
-            indexCache.push_back(startIndex + 3);
-            indexCache.push_back(startIndex + 4);
-            indexCache.push_back(startIndex + 5);
+        // The whole section goes up on the next upload
+        if (!mesh.vertices.empty()) {
+            patch->dirtyBegin = 0;
+            patch->dirtyEnd = static_cast<uint32_t>(mesh.vertices.size() / 4);
         }
+        sectionPatches[section] = std::move(patch);
+        patchedSections |= 1ull << section;
+        dirtySections &= ~(1ull << section);
+        meshCacheStale = true;
+        uploadPendingSections |= 1ull << section;
+    }
+
+    static uint32_t patchKey(int x, int y, int z, int faceIndex) {
+        uint32_t local = (x % SECTION_SIZE) + (y % SECTION_SIZE) * SECTION_SIZE + (z % SECTION_SIZE) * SECTION_SIZE * SECTION_SIZE;
+        return local * 6 + faceIndex;
+    }
+
+    // Bring one face's quad in line with the voxels: add, recolor or free it
+    void patchFace(int x, int y, int z, int faceIndex) {
+        int section = sectionIndexOf(x, y, z);
+        if (!isSectionPatched(section)) {
+            // An air voxel had no faces in the old mesh and gets none now
+            if (!isSolid(x, y, z)) return;
+            beginPatching(section); // Built from the current voxels, nothing left to patch
+            return;
+        }
+
+        SectionMesh& mesh = sectionMeshes[section];
+        SectionPatch& patch = *sectionPatches[section];
+        uint32_t key = patchKey(x, y, z, faceIndex);
+        auto it = patch.faceToQuad.find(key);
+        bool visible = isSolid(x, y, z) && isFaceExposed(x, y, z, faceIndex);
+
+        if (visible) {
+            uint32_t quad;
+            if (it != patch.faceToQuad.end()) {
+                quad = it->second;
+            } else if (!patch.freeQuads.empty()) {
+                quad = patch.freeQuads.back();
+                patch.freeQuads.pop_back();
+            } else {
+                quad = static_cast<uint32_t>(mesh.vertices.size() / 4);
+            }
+            const VoxelData& voxel = palette[paletteIndexAt(x, y, z)];
+            writeFace(mesh, quad, glm::ivec3(x, y, z), glm::ivec3(1), voxel.color, voxel.textureId, faceIndex);
+            patch.faceToQuad[key] = quad;
+            patch.markDirty(quad);
+        } else if (it != patch.faceToQuad.end()) {
+            // Collapse the quad to a degenerate triangle pair and keep the slot for reuse
+            uint32_t quad = it->second;
+            std::fill_n(mesh.indices.begin() + quad * 6, 6, quad * 4);
+            patch.freeQuads.push_back(quad);
+            patch.faceToQuad.erase(it);
+            patch.markDirty(quad);
+        } else {
+            return;
+        }
+        uploadPendingSections |= 1ull << section;
+    }
+
+    // An entry no voxel references any more; its slot is reused by the next new value
+    void releasePaletteEntry(uint32_t index) {
+        auto it = paletteLookup.find(palette[index]);
+        if (it != paletteLookup.end() && it->second == index) paletteLookup.erase(it);
+        if (lastPaletteLookup == index) lastPaletteLookup = 0;
+        freePaletteSlots.push_back(index);
+    }
+
+    // Point an in-range voxel at a palette entry, materializing its brick on the
+    // first write that differs from the brick's uniform value.
+    // Returns true when the voxel switched between air and solid.
+    bool setPaletteIndex(int x, int y, int z, uint32_t paletteIndex) {
+        if (bricks.empty()) {
+            if (paletteIndex == 0) return false;
+            bricks.assign(BRICK_COUNT, Brick());
+        }
+
+        Brick& brick = bricks[brickIndexOf(x, y, z)];
+        int local = localIndexOf(x, y, z);
+        uint32_t previous = brick.isUniform() ? brick.uniformIndex : brick.indices.get(local);
+        if (previous == paletteIndex) return false;
+
+        if (brick.isUniform()) {
+            brick.indices = BitPackedArray(BRICK_VOLUME, indexBits);
+            brick.indices.fill(brick.uniformIndex);
+        }
+
+        if (--paletteRefCounts[previous] == 0 && previous != 0) releasePaletteEntry(previous);
+        ++paletteRefCounts[paletteIndex];
+        brick.indices.set(local, paletteIndex);
+
+        bool solid = palette[paletteIndex].type != 0;
+        if (solid == (palette[previous].type != 0)) return false;
+
+        if (occupancy.empty()) occupancy.assign(OCCUPANCY_WORDS, 0);
+        uint64_t bit = 1ull << (x & 63);
+        uint64_t& word = occupancy[occupancyWordIndex(x, y, z)];
+        word = solid ? (word | bit) : (word & ~bit);
+        return true;
     }
 
     // void addFace(const glm::vec3& pos, const glm::vec4& color, int faceIndex) {
@@ -382,84 +1680,83 @@ private:
     //     indexCache.push_back(baseIndex + 3);
     // }
 
-    void addFace(const glm::vec3& pos, const glm::vec4& color, int textureId, int faceIndex) {
-        uint32_t baseIndex = static_cast<uint32_t>(vertexCache.size());
+    // Add a face quad at chunk-relative voxel origin. size is the quad extent in voxels
+    // along each axis (the component along the face normal is ignored), so greedy-merged
+    // faces come through here too. Vertices are packed; voxel.vert derives UVs from the
+    // corner positions so a repeating texture tiles once per voxel.
+    void addFace(SectionMesh& mesh, const glm::ivec3& origin, const glm::ivec3& size, const glm::vec4& color, int textureId, int faceIndex) {
+        writeFace(mesh, static_cast<uint32_t>(mesh.vertices.size() / 4), origin, size, color, textureId, faceIndex);
+    }
+
+    // Write a face into quad slot `quad` (4 vertices, 6 indices), appending when the
+    // slot is one past the end
+    void writeFace(SectionMesh& mesh, uint32_t quad, const glm::ivec3& origin, const glm::ivec3& size, const glm::vec4& color, int textureId, int faceIndex) {
+        uint32_t baseIndex = quad * 4;
+        if (baseIndex == mesh.vertices.size()) {
+            mesh.vertices.resize(baseIndex + 4);
+            mesh.indices.resize(quad * 6 + 6);
+        }
         
         // Define face vertices based on direction
         // Vertices are ordered counter-clockwise when viewed from outside
-        glm::vec3 vertices[4];
-        glm::vec3 normal;
+        glm::ivec3 corners[4];
         
         switch (faceIndex) {
             case 0: // Top (+Y) - looking down at it
-                vertices[0] = pos + glm::vec3(0, VOXEL_SIZE, 0);
-                vertices[1] = pos + glm::vec3(0, VOXEL_SIZE, VOXEL_SIZE);
-                vertices[2] = pos + glm::vec3(VOXEL_SIZE, VOXEL_SIZE, VOXEL_SIZE);
-                vertices[3] = pos + glm::vec3(VOXEL_SIZE, VOXEL_SIZE, 0);
-                normal = glm::vec3(0, 1, 0);
+                corners[0] = glm::ivec3(0, 1, 0);
+                corners[1] = glm::ivec3(0, 1, size.z);
+                corners[2] = glm::ivec3(size.x, 1, size.z);
+                corners[3] = glm::ivec3(size.x, 1, 0);
                 break;
             case 1: // Bottom (-Y) - looking up at it
-                vertices[0] = pos + glm::vec3(0, 0, 0);
-                vertices[1] = pos + glm::vec3(VOXEL_SIZE, 0, 0);
-                vertices[2] = pos + glm::vec3(VOXEL_SIZE, 0, VOXEL_SIZE);
-                vertices[3] = pos + glm::vec3(0, 0, VOXEL_SIZE);
-                normal = glm::vec3(0, -1, 0);
+                corners[0] = glm::ivec3(0, 0, 0);
+                corners[1] = glm::ivec3(size.x, 0, 0);
+                corners[2] = glm::ivec3(size.x, 0, size.z);
+                corners[3] = glm::ivec3(0, 0, size.z);
                 break;
             case 2: // Right (+X) - looking from the right
-                vertices[0] = pos + glm::vec3(VOXEL_SIZE, 0, 0);
-                vertices[1] = pos + glm::vec3(VOXEL_SIZE, VOXEL_SIZE, 0);
-                vertices[2] = pos + glm::vec3(VOXEL_SIZE, VOXEL_SIZE, VOXEL_SIZE);
-                vertices[3] = pos + glm::vec3(VOXEL_SIZE, 0, VOXEL_SIZE);
-                normal = glm::vec3(1, 0, 0);
+                corners[0] = glm::ivec3(1, 0, 0);
+                corners[1] = glm::ivec3(1, size.y, 0);
+                corners[2] = glm::ivec3(1, size.y, size.z);
+                corners[3] = glm::ivec3(1, 0, size.z);
                 break;
             case 3: // Left (-X) - looking from the left
-                vertices[0] = pos + glm::vec3(0, 0, 0);
-                vertices[1] = pos + glm::vec3(0, 0, VOXEL_SIZE);
-                vertices[2] = pos + glm::vec3(0, VOXEL_SIZE, VOXEL_SIZE);
-                vertices[3] = pos + glm::vec3(0, VOXEL_SIZE, 0);
-                normal = glm::vec3(-1, 0, 0);
+                corners[0] = glm::ivec3(0, 0, 0);
+                corners[1] = glm::ivec3(0, 0, size.z);
+                corners[2] = glm::ivec3(0, size.y, size.z);
+                corners[3] = glm::ivec3(0, size.y, 0);
                 break;
             case 4: // Front (+Z) - looking from the front
-                vertices[0] = pos + glm::vec3(0, 0, VOXEL_SIZE);
-                vertices[1] = pos + glm::vec3(VOXEL_SIZE, 0, VOXEL_SIZE);
-                vertices[2] = pos + glm::vec3(VOXEL_SIZE, VOXEL_SIZE, VOXEL_SIZE);
-                vertices[3] = pos + glm::vec3(0, VOXEL_SIZE, VOXEL_SIZE);
-                normal = glm::vec3(0, 0, 1);
+                corners[0] = glm::ivec3(0, 0, 1);
+                corners[1] = glm::ivec3(size.x, 0, 1);
+                corners[2] = glm::ivec3(size.x, size.y, 1);
+                corners[3] = glm::ivec3(0, size.y, 1);
                 break;
             case 5: // Back (-Z) - looking from the back
-                vertices[0] = pos + glm::vec3(0, 0, 0);
-                vertices[1] = pos + glm::vec3(0, VOXEL_SIZE, 0);
-                vertices[2] = pos + glm::vec3(VOXEL_SIZE, VOXEL_SIZE, 0);
-                vertices[3] = pos + glm::vec3(VOXEL_SIZE, 0, 0);
-                normal = glm::vec3(0, 0, -1);
+                corners[0] = glm::ivec3(0, 0, 0);
+                corners[1] = glm::ivec3(0, size.y, 0);
+                corners[2] = glm::ivec3(size.x, size.y, 0);
+                corners[3] = glm::ivec3(size.x, 0, 0);
                 break;
         }
 
         // Add vertices
         for (int i = 0; i < 4; ++i) {
-            Vertex v;
-            v.position = vertices[i];
-            // Assign texture coordinates based on vertex index for a full texture map per face
-            if (i == 0) v.texCoords = glm::vec2(0.0f, 0.0f);
-            else if (i == 1) v.texCoords = glm::vec2(0.0f, 1.0f);
-            else if (i == 2) v.texCoords = glm::vec2(1.0f, 1.0f);
-            else if (i == 3) v.texCoords = glm::vec2(1.0f, 0.0f);
-            v.color = color;
-            v.gradientCoords = glm::vec2(0.0f);
-            v.objectType = 6.0f;
-            v.normal = normal;
-            v.textureId = static_cast<float>(textureId); // Assign the texture ID
-            vertexCache.push_back(v);
+            glm::ivec3 corner = origin + corners[i];
+            mesh.vertices[baseIndex + i] = VoxelVertex::pack(corner, faceIndex, textureId, color);
+            mesh.boundsMin = glm::min(mesh.boundsMin, corner);
+            mesh.boundsMax = glm::max(mesh.boundsMax, corner);
         }
         
         // Add indices (counter-clockwise winding)
-        indexCache.push_back(baseIndex + 0);
-        indexCache.push_back(baseIndex + 1);
-        indexCache.push_back(baseIndex + 2);
+        uint32_t* indices = &mesh.indices[quad * 6];
+        indices[0] = baseIndex + 0;
+        indices[1] = baseIndex + 1;
+        indices[2] = baseIndex + 2;
         
-        indexCache.push_back(baseIndex + 0);
-        indexCache.push_back(baseIndex + 2);
-        indexCache.push_back(baseIndex + 3);
+        indices[3] = baseIndex + 0;
+        indices[4] = baseIndex + 2;
+        indices[5] = baseIndex + 3;
     }
 
     // Alternative: If you truly need double-sided faces
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <map>
+#include <cstdint>
+
+#include "Chunk.h"
+
+// Recently unloaded chunks kept in RAM in their compressed save format, so coming
+// back to them is a decode instead of a disk read. Entries are dropped least
+// recently unloaded first once their bytes pass the memory budget, and taking a
+// chunk removes its entry, so an entry is never older than the chunk it holds.
+//
+// insert runs on the main thread and keeps the unloaded chunk itself until
+// compress, run on a worker, replaces it with its encoded bytes. A chunk taken
+// before that is copied from the held one. Held chunks count against the budget
+// at their in-memory size until they are compressed.
+class ChunkCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0; // Encoded or held chunks and mesh caches
+        size_t budget = 0;
+    };
+
+    explicit ChunkCache(size_t budgetBytes) : budget(budgetBytes) {}
+
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    // meshCache holds the chunk's encoded meshes, or is empty if they were not
+    // complete. generated marks chunks made by the terrain generator and not saved.
+    void insert(const Chunk::ChunkCoord& coord, std::shared_ptr<const Chunk> chunk, std::string meshCache, bool generated) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (budget == 0) return;
+        removeEntry(coord);
+        lru.push_front(coord);
+        Entry& entry = entries[coord];
+        entry.chunk = std::move(chunk);
+        entry.meshCache = std::move(meshCache);
+        entry.generated = generated;
+        entry.lruPosition = lru.begin();
+        entry.chunkBytes = entry.chunk ? sizeof(Chunk) + entry.chunk->memoryUsage() : 0;
+        bytes += entryBytes(entry);
+        evictOverBudget();
+    }
+
+    // Encode a chunk given to insert; does nothing if it was taken or replaced since
+    void compress(const Chunk::ChunkCoord& coord, const std::shared_ptr<const Chunk>& chunk) {
+        std::ostringstream out;
+        chunk->saveToBinary(out);
+        std::string encoded = std::move(out).str();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(coord);
+        if (it == entries.end() || it->second.chunk != chunk) return;
+        it->second.chunk.reset();
+        bytes -= it->second.chunkBytes;
+        it->second.chunkBytes = 0;
+        it->second.encoded = std::move(encoded);
+        bytes += it->second.encoded.size();
+        evictOverBudget();
+    }
+
+    // Remove the chunk and return it decoded, with its mesh cache if it had one and
+    // whether it was generated. Null if the chunk is not cached.
+    std::unique_ptr<Chunk> take(const Chunk::ChunkCoord& coord, std::string& meshCache, bool& generated) {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(coord);
+            if (it == entries.end()) {
+                ++misses;
+                return nullptr;
+            }
+            entry = std::move(it->second);
+            lru.erase(entry.lruPosition);
+            entries.erase(it);
+            bytes -= entryBytes(entry);
+        }
+
+        std::unique_ptr<Chunk> chunk;
+        if (entry.chunk) {
+            chunk = entry.chunk->createSnapshot(); // Not compressed yet
+        } else {
+            chunk = std::make_unique<Chunk>(coord);
+            if (!chunk->loadFromMemory(reinterpret_cast<const uint8_t*>(entry.encoded.data()), entry.encoded.size())) {
+                chunk.reset();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++(chunk ? hits : misses);
+        }
+        if (!chunk) return nullptr;
+        meshCache = std::move(entry.meshCache);
+        generated = entry.generated;
+        return chunk;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        clearLocked();
+    }
+
+    // A budget of 0 turns the cache off
+    void setBudget(size_t budgetBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        budget = budgetBytes;
+        if (budget == 0) {
+            clearLocked();
+        } else {
+            evictOverBudget();
+        }
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.evictions = evictions;
+        stats.entries = entries.size();
+        stats.bytes = bytes;
+        stats.budget = budget;
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const Chunk> chunk; // Until compressed
+        size_t chunkBytes = 0;              // Memory charged for chunk
+        std::string encoded;
+        std::string meshCache;
+        bool generated = false;
+        std::list<Chunk::ChunkCoord>::iterator lruPosition;
+    };
+
+    std::map<Chunk::ChunkCoord, Entry> entries;
+    std::list<Chunk::ChunkCoord> lru; // Most recently inserted first
+    size_t budget;
+    size_t bytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    std::mutex mutex;
+
+    static size_t entryBytes(const Entry& entry) {
+        return entry.chunkBytes + entry.encoded.size() + entry.meshCache.size();
+    }
+
+    void removeEntry(const Chunk::ChunkCoord& coord) {
+        auto it = entries.find(coord);
+        if (it == entries.end()) return;
+        bytes -= entryBytes(it->second);
+        lru.erase(it->second.lruPosition);
+        entries.erase(it);
+    }
+
+    void evictOverBudget() {
+        while (bytes > budget && !lru.empty()) {
+            Chunk::ChunkCoord oldest = lru.back();
+            removeEntry(oldest);
+            ++evictions;
+        }
+    }
+
+    void clearLocked() {
+        entries.clear();
+        lru.clear();
+        bytes = 0;
+    }
+};
@@ -11,6 +11,14 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
 
 #include "ChunkManager.h"
 #include <glm/glm.hpp>
@@ -23,20 +31,34 @@
 #include "PhysicsSystem.h" // For PhysicsSystem::RayCastResult
 
 #include "TerrainGenerator.h"
-
-// Custom hash for ChunkCoord
+#include "ThreadPool.h"
+#include "MpscQueue.h"
+#include "RegionFile.h"
+#include "WorldManifest.h"
+#include "EditJournal.h"
+#include "FlatHashMap.h"
+#include "ChunkCache.h"
+#include "StreamingStats.h"
+
+// Custom hash for ChunkCoord. Coordinates on a regular grid differ only in a few
+// low bits, so they are packed 21 bits each and run through a 64-bit finalizer
+// (splitmix64) that spreads every input bit over the whole result.
 namespace std {
     template<>
     struct hash<Chunk::ChunkCoord> {
         size_t operator()(const Chunk::ChunkCoord& c) const {
-            return ((hash<int>()(c.x) ^ (hash<int>()(c.y) << 1)) >> 1) ^ (hash<int>()(c.z) << 1);
+            uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(c.x)) ^
+                         (static_cast<uint64_t>(static_cast<uint32_t>(c.y)) << 21) ^
+                         (static_cast<uint64_t>(static_cast<uint32_t>(c.z)) << 42);
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+            return static_cast<size_t>(h ^ (h >> 31));
         }
     };
 }
 
 class ChunkManager {
 public:
-    TerrainGenerator terrainGenerator;
     Octree<Chunk::PhysicsVoxelData> physicsOctree; 
 
     ChunkManager(const std::string& worldPath = "world_data", int grassTex = 0, int dirtTex = 0, int stoneTex = 0) 
@@ -44,109 +66,193 @@ public:
           worldDataPath(worldPath),
           loadRadius(3),
           unloadRadius(5),
-          physicsOctree() { // Initialize Octree with a large enough bounds
+          physicsOctree(), // Initialize Octree with a large enough bounds
+          meshQueue(std::make_unique<MeshQueue>()),
+          loadQueue(std::make_unique<LoadQueue>(worldPath)) {
+        loadQueue->generator.set(std::make_shared<const TerrainGenerator>(terrainGenerator));
         // Create world data directory if it doesn't exist
         std::filesystem::create_directories(worldDataPath);
         LOG("ChunkManager initialized with path: " + worldDataPath);
     }
     
     void clearWorld() {
+        worldGeneration.reset(); // Cancels it and waits for the chunk being written
+
         // Unload all chunks without saving
         std::vector<Chunk::ChunkCoord> toUnload;
         for (const auto& pair : loadedChunks) {
             toUnload.push_back(pair.first);
         }
         for (const auto& coord : toUnload) {
-            unloadChunk(coord);
+            unloadChunk(coord, false);
         }
         loadedChunks.clear();
+        lastHitChunk = nullptr;
         modifiedChunks.clear();
+        generatedChunks.clear();
         missingChunks.clear();
+        cancelPendingLoads();
         physicsOctree.clear();
 
-        // Delete all chunk files
+        // Delete all region files, and chunk files left from before regions
+        loadQueue->saves.cancel();
+        loadQueue->journal.clear();
+        loadQueue->memoryCache.clear();
+        loadQueue->chunkRegions.removeAll();
+        loadQueue->meshRegions.removeAll();
+        loadQueue->manifest.clear();
         for (const auto& entry : std::filesystem::directory_iterator(worldDataPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".dat") {
+            if (entry.is_regular_file() && (entry.path().extension() == ".dat" || entry.path().extension() == ".mesh")) {
                 std::filesystem::remove(entry.path());
             }
         }
     }
 
+    // Chunks that are not on disk are generated by this as they come into range.
+    // Unmodified generated chunks are dropped on unload and never saved, so
+    // changing the generator regenerates them; modified chunks are kept.
+    void setTerrainGenerator(const TerrainGenerator& generator) {
+        terrainGenerator = generator;
+        loadQueue->generator.set(std::make_shared<const TerrainGenerator>(generator));
+
+        std::vector<Chunk::ChunkCoord> stale;
+        for (const auto& coord : generatedChunks) {
+            if (!modifiedChunks.contains(coord)) stale.push_back(coord);
+        }
+        for (const auto& coord : stale) {
+            unloadChunk(coord, false);
+        }
+        loadQueue->memoryCache.clear(); // Modified chunks in it are queued for saving
+        missingChunks.clear();
+        cancelPendingLoads();
+    }
+
+    const TerrainGenerator& getTerrainGenerator() const { return terrainGenerator; }
+
+    // Replace the world with numChunksX x numChunksY x numChunksZ chunks of the
+    // current terrain, generated and saved in the background. Streaming pauses
+    // until it finishes or is cancelled; chunks a cancelled run did not reach are
+    // generated as they come into range like any chunk missing from disk.
     void generateWorld(int numChunksX, int numChunksY, int numChunksZ) {
         clearWorld();
         LOG("Starting generation of new world...");
 
+        std::vector<Chunk::ChunkCoord> coords;
         for (int x = 0; x < numChunksX; ++x) {
             for (int y = 0; y < numChunksY; ++y) {
                 for (int z = 0; z < numChunksZ; ++z) {
-                    Chunk::ChunkCoord coord{x, y, z};
-                    auto chunk = std::make_unique<Chunk>(coord);
-                    terrainGenerator.generateChunk(chunk.get());
-                    saveChunk(coord, chunk.get());
+                    coords.push_back(Chunk::ChunkCoord{x, y, z});
                 }
             }
         }
-        LOG("New world generation complete.");
+        worldGeneration = std::make_unique<WorldGeneration>(loadQueue->chunkRegions, loadQueue->manifest, loadQueue->generator.get(), coords);
+    }
+
+    struct WorldGenerationProgress {
+        size_t total = 0;
+        size_t generated = 0;
+        size_t written = 0;
+        bool running = false;
+        bool cancelled = false;
+    };
+
+    WorldGenerationProgress getWorldGenerationProgress() const {
+        WorldGenerationProgress progress;
+        if (!worldGeneration) return progress;
+        progress.total = worldGeneration->total;
+        progress.generated = worldGeneration->generated;
+        progress.written = worldGeneration->written;
+        progress.running = worldGeneration->running();
+        progress.cancelled = worldGeneration->cancelled;
+        return progress;
+    }
+
+    bool isGeneratingWorld() const { return worldGeneration != nullptr; }
+
+    // Stop generating; chunks already written are kept
+    void cancelWorldGeneration() {
+        if (worldGeneration) worldGeneration->cancel();
+    }
+
+    // Block until the running world generation is done, e.g. for tools and tests
+    void waitForWorldGeneration() {
+        if (!worldGeneration) return;
+        worldGeneration->wait();
+        finishWorldGeneration();
     }
     
-    // Update which chunks should be loaded based on camera position
-    void updateLoadedChunks(const glm::vec3& cameraPosition) {
-        Chunk::ChunkCoord centerChunk = worldToChunkCoord(cameraPosition);
-        
-        // Queue chunks to load
-        std::vector<Chunk::ChunkCoord> chunksToLoad;
-        for (int x = -loadRadius; x <= loadRadius; ++x) {
-            for (int y = -loadRadius; y <= loadRadius; ++y) {
-                for (int z = -loadRadius; z <= loadRadius; ++z) {
-                    Chunk::ChunkCoord coord{
-                        centerChunk.x + x,
-                        centerChunk.y + y,
-                        centerChunk.z + z
-                    };
-                    
-                    // Check if within sphere (not cube)
-                    float dist = glm::length(glm::vec3(x, y, z));
-                    // if (dist <= loadRadius && loadedChunks.find(coord) == loadedChunks.end()) {
-                    //     chunksToLoad.push_back(coord);
-                    // }
-
-                    if (dist <= loadRadius &&
-                        loadedChunks.find(coord) == loadedChunks.end() &&
-                        missingChunks.find(coord) == missingChunks.end()) {
-                        chunksToLoad.push_back(coord);
-                    }
-                }
-            }
+    // Update which chunks should be loaded based on camera position. The wanted set
+    // only changes when the camera enters another chunk, the camera's predicted
+    // chunk changes or a radius changes, so most frames just reprioritize queued
+    // loads for the view and install chunks the loaders finished until the
+    // frame's load budget runs out.
+    void updateLoadedChunks(const glm::vec3& cameraPosition, const glm::vec3& viewDirection = glm::vec3(0.0f)) {
+        if (worldGeneration) {
+            if (worldGeneration->running()) return;
+            finishWorldGeneration();
         }
-        
-        // Load new chunks
-        for (const auto& coord : chunksToLoad) {
-            loadChunk(coord);
-        }
-        
-        // Unload distant chunks
-        std::vector<Chunk::ChunkCoord> chunksToUnload;
-        for (const auto& [coord, chunk] : loadedChunks) {
-            float dist = glm::length(glm::vec3(
-                coord.x - centerChunk.x,
-                coord.y - centerChunk.y,
-                coord.z - centerChunk.z
-            ));
-            
-            if (dist > unloadRadius) {
-                chunksToUnload.push_back(coord);
+
+        updateCameraVelocity(cameraPosition);
+        Chunk::ChunkCoord centerChunk = worldToChunkCoord(cameraPosition);
+        glm::vec3 lookahead = cameraVelocity * prefetchSeconds;
+        float maxLookahead = MAX_PREFETCH_CHUNKS * Chunk::CHUNK_SIZE * Chunk::VOXEL_SIZE;
+        if (glm::length(lookahead) > maxLookahead) lookahead *= maxLookahead / glm::length(lookahead);
+        Chunk::ChunkCoord predictedChunk = worldToChunkCoord(cameraPosition + lookahead);
+        if (!loadSetValid || !(centerChunk == streamCenter) || !(predictedChunk == prefetchCenter) ||
+            loadSetRadius != loadRadius || loadSetUnloadRadius != unloadRadius) {
+            updateLoadSet(centerChunk, predictedChunk, cameraPosition, viewDirection);
+        } else {
+            // Nearest and most in view first
+            std::lock_guard<std::mutex> lock(loadQueue->mutex);
+            for (LoadRequest& request : loadQueue->requests) {
+                request.priority = requestPriority(request.coord, cameraPosition, viewDirection);
             }
         }
-        
-        for (const auto& coord : chunksToUnload) {
-            unloadChunk(coord);
+
+        installLoadedChunks();
+        sampleQueueDepths();
+    }
+
+    // Main thread time per frame spent installing chunks the loaders finished
+    // (physics inserts, neighbor links)
+    void setLoadBudgetMs(float milliseconds) { loadBudgetMs = milliseconds; }
+    float getLoadBudgetMs() const { return loadBudgetMs; }
+
+    // Chunks requested from the loaders and not installed yet
+    size_t getPendingLoadCount() const { return pendingLoads.size(); }
+
+    // Chunks along the camera's path for this many seconds ahead, at its current
+    // velocity, are loaded after the ones in range; 0 turns this off
+    void setPrefetchSeconds(float seconds) { prefetchSeconds = std::max(seconds, 0.0f); }
+    float getPrefetchSeconds() const { return prefetchSeconds; }
+
+    // Smoothed camera velocity in world units per second, as seen by updateLoadedChunks
+    const glm::vec3& getCameraVelocity() const { return cameraVelocity; }
+
+    // Per-stage streaming timings and queue depths; the renderer adds upload and
+    // frame times
+    StreamingStats& getStreamingStats() { return *loadQueue->stats; }
+
+    bool exportStreamingStats(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) {
+            LOG("ERROR: Could not open " + path + " for streaming stats");
+            return false;
         }
+        loadQueue->stats->writeCsv(out);
+        LOG("Wrote streaming stats to " + path);
+        return out.good();
     }
     
-    // Get chunk at coordinate (returns nullptr if not loaded)
+    // Get chunk at coordinate (returns nullptr if not loaded). Ray casts and edits
+    // ask for the same chunk many times in a row, so the last hit is remembered.
     Chunk* getChunk(const Chunk::ChunkCoord& coord) {
+        if (lastHitChunk && coord == lastHitCoord) return lastHitChunk;
         auto it = loadedChunks.find(coord);
-        return (it != loadedChunks.end()) ? it->second.get() : nullptr;
+        if (it == loadedChunks.end()) return nullptr;
+        lastHitCoord = coord;
+        lastHitChunk = it->second.get();
+        return lastHitChunk;
     }
     
     // Get chunk at world position
@@ -172,7 +278,9 @@ public:
     //     modifiedChunks.insert(chunkCoord);
     // }
 
-    void setVoxelWorld(const glm::vec3& worldPos, const Chunk::VoxelData& data) {
+    // patchMesh updates the chunk mesh in place for low-latency interactive edits;
+    // call finishEditStroke once the stroke is over to restore greedy meshes
+    void setVoxelWorld(const glm::vec3& worldPos, const Chunk::VoxelData& data, bool patchMesh = false) {
         Chunk::ChunkCoord chunkCoord = worldToChunkCoord(worldPos);
         Chunk* chunk = getChunk(chunkCoord);
 
@@ -187,9 +295,24 @@ public:
         }
 
         glm::ivec3 localPos = worldToLocalVoxel(worldPos, chunkCoord);
-        chunk->setVoxel(localPos.x, localPos.y, localPos.z, data);
+        if (patchMesh) {
+            chunk->setVoxelPatched(localPos.x, localPos.y, localPos.z, data);
+        } else {
+            chunk->setVoxel(localPos.x, localPos.y, localPos.z, data);
+        }
+        loadQueue->journal.record(chunkCoord, localPos.x, localPos.y, localPos.z, data);
         modifiedChunks.insert(chunkCoord);
     }
+
+    // Queue every chunk patched during an edit stroke for greedy remeshing. Patches
+    // can reach into unmodified neighbor chunks, so all loaded chunks are checked.
+    void finishEditStroke() {
+        for (auto& [coord, chunk] : loadedChunks) {
+            if (chunk->isPatching()) {
+                chunk->finishPatching();
+            }
+        }
+    }
     
     // Get voxel at world position
     Chunk::VoxelData getVoxelWorld(const glm::vec3& worldPos) {
@@ -202,37 +325,161 @@ public:
         return chunk->getVoxel(localPos.x, localPos.y, localPos.z);
     }
     
-    // Rebuild meshes for dirty chunks
+    // Queue a mesh job for every dirty chunk, covering just its dirty sections. Jobs
+    // mesh a snapshot of the voxels on the worker pool; results are installed by
+    // integrateFinishedMeshes. Sections that change while a job runs stay dirty and
+    // are queued again afterwards.
     void rebuildDirtyChunks() {
         for (auto& [coord, chunk] : loadedChunks) {
-            if (chunk->isDirty()) {
-                chunk->rebuildMesh();
+            if (!chunk->isDirty() || meshJobsInFlight.count(coord)) continue;
+
+            uint64_t jobId = ++nextMeshJobId;
+            meshJobsInFlight[coord] = jobId;
+
+            MeshResult job;
+            job.coord = coord;
+            job.jobId = jobId;
+            job.sections = chunk->takeDirtySections();
+            job.meshes.resize(std::popcount(job.sections));
+            for (Chunk::SectionMesh& mesh : job.meshes) {
+                if (spareSectionMeshes.empty()) break;
+                mesh = std::move(spareSectionMeshes.back());
+                spareSectionMeshes.pop_back();
             }
+
+            // Shared so the task stays copyable for std::function
+            auto snapshot = std::shared_ptr<Chunk>(chunk->createSnapshot());
+            auto layers = std::make_shared<Chunk::NeighborLayers>(chunk->gatherNeighborLayers());
+            auto result = std::make_shared<MeshResult>(std::move(job));
+            MeshQueue* queue = meshQueue.get();
+            std::shared_ptr<StreamingStats> stats = loadQueue->stats;
+
+            queue->workers.submit([queue, snapshot, layers, result, stats] {
+                StreamingStats::Timer timer;
+                snapshot->swapSectionMeshes(result->sections, result->meshes);
+                snapshot->buildMesh(*layers, result->sections);
+                snapshot->swapSectionMeshes(result->sections, result->meshes);
+                stats->record(StreamingStats::Metric::Mesh, timer.lap());
+
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->finished.push_back(std::move(*result));
+            });
         }
     }
+
+    // Install up to meshIntegrationsPerFrame finished meshes. Call on the main thread
+    // before recording the frame; the rest wait for the next frame.
+    void integrateFinishedMeshes() {
+        {
+            std::lock_guard<std::mutex> lock(meshQueue->mutex);
+            size_t count = std::min(meshIntegrationsPerFrame, meshQueue->finished.size());
+            for (size_t i = 0; i < count; ++i) {
+                readyMeshes.push_back(std::move(meshQueue->finished.front()));
+                meshQueue->finished.pop_front();
+            }
+        }
+
+        for (MeshResult& result : readyMeshes) {
+            auto it = meshJobsInFlight.find(result.coord);
+            // Discard results for chunks that were unloaded (or reloaded) meanwhile
+            if (it != meshJobsInFlight.end() && it->second == result.jobId) {
+                meshJobsInFlight.erase(it);
+                if (Chunk* chunk = getChunk(result.coord)) {
+                    // Swap in the new meshes; the previous ones come back for reuse
+                    chunk->markUploadPending(chunk->swapSectionMeshes(result.sections, result.meshes));
+                }
+            }
+            for (Chunk::SectionMesh& mesh : result.meshes) {
+                mesh.clear();
+                spareSectionMeshes.push_back(std::move(mesh));
+            }
+        }
+        readyMeshes.clear();
+
+        // Keep a few buffers around, not one per section ever meshed
+        size_t maxSpares = meshQueue->workers.threadCount() * Chunk::SECTION_COUNT;
+        if (spareSectionMeshes.size() > maxSpares) {
+            spareSectionMeshes.resize(maxSpares);
+        }
+    }
+
+    void setMeshIntegrationsPerFrame(size_t count) { meshIntegrationsPerFrame = std::max<size_t>(count, 1); }
+    size_t getMeshJobsInFlight() const { return meshJobsInFlight.size(); }
     
-    // Save all modified chunks to disk
+    // Write mesh caches for every loaded chunk, e.g. on shutdown
+    void saveMeshCaches() {
+        for (const auto& [coord, chunk] : loadedChunks) {
+            saveMeshCache(coord, chunk.get());
+        }
+    }
+
+    // Edits are saved by appending them to the journal, which costs the same no
+    // matter how large the edited chunks are. Modified chunks stay marked so they
+    // are still written whole when they unload.
     void saveModifiedChunks() {
-        for (const auto& coord : modifiedChunks) {
+        if (!loadQueue->journal.flush()) {
+            // Fall back to writing the chunks themselves
+            for (const auto& coord : modifiedChunks) {
+                auto it = loadedChunks.find(coord);
+                if (it != loadedChunks.end()) {
+                    saveChunk(coord, it->second.get());
+                }
+            }
+            modifiedChunks.clear();
+            LOG("Queued all modified chunks for saving");
+            return;
+        }
+        if (loadQueue->journal.uncompactedEdits() >= JOURNAL_COMPACT_EDITS) {
+            compactJournal();
+        }
+    }
+
+    // Write the journaled edits into the chunk files in the background and delete
+    // the journal files they came from once that has succeeded. Runs once enough
+    // edits pile up and when the world is saved on shutdown, so a journal never
+    // outlives the session that wrote it.
+    void compactJournal() {
+        EditJournal& journal = loadQueue->journal;
+        if (!journal.flush() || journal.uncompactedEdits() == 0) return;
+        EditJournal::EditsByChunk closed;
+        uint64_t through = journal.rotate(closed);
+        for (const auto& [coord, edits] : closed) {
             auto it = loadedChunks.find(coord);
             if (it != loadedChunks.end()) {
+                // The loaded chunk already has every edit
                 saveChunk(coord, it->second.get());
+                modifiedChunks.erase(coord);
+            } else {
+                loadQueue->saves.saveEdits(coord, edits, getChunkFilePath(coord));
             }
         }
-        modifiedChunks.clear();
-        LOG("Saved all modified chunks");
+        loadQueue->saves.barrier([&journal, through](bool written) {
+            if (written) journal.dropThrough(through);
+        });
+        LOG("Compacting edit journal into " + std::to_string(closed.size()) + " chunks");
     }
     
-    // Save all loaded chunks (useful on shutdown)
+    // Save all loaded chunks (useful on shutdown), except generated ones nobody
+    // changed, and fold the journal into the chunks
     void saveAllChunks() {
+        compactJournal();
         for (const auto& [coord, chunk] : loadedChunks) {
+            if (generatedChunks.contains(coord) && !modifiedChunks.contains(coord)) continue;
             saveChunk(coord, chunk.get());
         }
-        LOG("Saved all loaded chunks");
+        LOG("Queued all loaded chunks for saving");
     }
+
+    // Recently unloaded chunks are kept compressed in RAM up to this many bytes
+    void setMemoryCacheBudget(size_t bytes) { loadQueue->memoryCache.setBudget(bytes); }
+    ChunkCache::Stats getMemoryCacheStats() { return loadQueue->memoryCache.getStats(); }
+
+    // Block until every save queued so far has been written, e.g. on shutdown
+    void flushSaves() { loadQueue->saves.flush(); }
+    size_t getPendingSaveCount() { return loadQueue->saves.pendingCount(); }
     
     // Get all loaded chunks
-    const std::unordered_map<Chunk::ChunkCoord, std::unique_ptr<Chunk>>& getLoadedChunks() const {
+    const FlatHashMap<Chunk::ChunkCoord, std::unique_ptr<Chunk>>& getLoadedChunks() const {
         return loadedChunks;
     }
 
@@ -354,12 +601,905 @@ public:
     
 
 private:
-    std::unordered_map<Chunk::ChunkCoord, std::unique_ptr<Chunk>> loadedChunks;
-    std::unordered_set<Chunk::ChunkCoord> modifiedChunks;
-    std::unordered_set<Chunk::ChunkCoord> missingChunks;
+    TerrainGenerator terrainGenerator;
+    FlatHashMap<Chunk::ChunkCoord, std::unique_ptr<Chunk>> loadedChunks;
+    FlatHashSet<Chunk::ChunkCoord> modifiedChunks;
+    FlatHashSet<Chunk::ChunkCoord> missingChunks;
+    FlatHashSet<Chunk::ChunkCoord> generatedChunks; // Loaded from the generator and not saved since
+    Chunk::ChunkCoord lastHitCoord{};
+    Chunk* lastHitChunk = nullptr; // getChunk's last result; reset when chunks are removed
     std::string worldDataPath;
     int loadRadius;
     int unloadRadius;
+
+    // Section meshes cycle between chunks and jobs so their vertex/index capacity
+    // is reused instead of reallocated on every rebuild.
+    struct MeshResult {
+        Chunk::ChunkCoord coord{};
+        uint64_t jobId = 0;
+        uint64_t sections = 0;                  // Sections rebuilt by this job
+        std::vector<Chunk::SectionMesh> meshes; // One per set bit of sections, lowest first
+    };
+
+    // State shared with the mesh workers. Held by pointer so ChunkManager stays
+    // movable; workers are declared last so they are joined before the queue dies.
+    struct MeshQueue {
+        std::mutex mutex;
+        std::deque<MeshResult> finished;
+        ThreadPool workers;
+    };
+
+    // A chunk to read on a loader thread. Lower priority values load first.
+    struct LoadRequest {
+        Chunk::ChunkCoord coord{};
+        float priority = 0.0f;
+        uint64_t epoch = 0;
+        std::string legacyFilePath; // Per-chunk file read when the region has no entry
+        std::chrono::steady_clock::time_point requested = std::chrono::steady_clock::now();
+    };
+
+    // Everything about a chunk that can be prepared off the main thread
+    struct LoadResult {
+        Chunk::ChunkCoord coord{};
+        uint64_t epoch = 0;
+        std::unique_ptr<Chunk> chunk; // Null when the chunk is not on disk or unreadable
+        std::vector<Chunk::PhysicsVoxelData> physicsVoxels;
+        size_t physicsInserted = 0;   // Prefix of physicsVoxels already in the octree
+        bool meshCached = false;
+        bool generated = false;       // Not on disk; made by the terrain generator
+        std::chrono::steady_clock::time_point requested;
+        float installMs = 0.0f;       // Main thread time spent installing so far
+    };
+
+    // Terrain generator shared with the loader and writer threads; replaced whole
+    // when the settings change
+    struct SharedGenerator {
+        std::shared_ptr<const TerrainGenerator> get() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return current;
+        }
+        void set(std::shared_ptr<const TerrainGenerator> generator) {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = std::move(generator);
+        }
+
+    private:
+        std::mutex mutex;
+        std::shared_ptr<const TerrainGenerator> current;
+    };
+
+    // Region entries of edited terrain may hold only the voxels that differ from
+    // what the generator makes for the chunk, with the generator settings so the
+    // baseline can be made again after the world's settings change
+    struct ChunkDeltaHeader {
+        uint32_t magic;
+        uint32_t version;
+        Chunk::ChunkCoord coord;
+        int32_t seed;
+        float frequency;
+        int32_t octaves;
+        int32_t textureIds[3]; // Grass, dirt, stone
+    };
+    static constexpr uint32_t CHUNK_DELTA_MAGIC = 0x4C445856; // "VXDL"
+    static constexpr uint32_t CHUNK_DELTA_VERSION = 1;
+
+    // Region entry for a chunk: a delta against the generator's terrain when that
+    // is smaller than the full encoding, else the full encoding
+    static std::string encodeStoredChunk(const Chunk& chunk, const TerrainGenerator* generator) {
+        std::ostringstream out;
+        chunk.saveToBinary(out);
+        std::string full = std::move(out).str();
+        if (!generator || full.size() <= sizeof(ChunkDeltaHeader)) return full;
+
+        Chunk baseline(chunk.getCoordinate());
+        generator->generateChunk(&baseline);
+
+        ChunkDeltaHeader header{};
+        header.magic = CHUNK_DELTA_MAGIC;
+        header.version = CHUNK_DELTA_VERSION;
+        header.coord = chunk.getCoordinate();
+        header.seed = generator->getSeed();
+        header.frequency = generator->getFrequency();
+        header.octaves = generator->getOctaves();
+        header.textureIds[0] = generator->getGrassTextureId();
+        header.textureIds[1] = generator->getDirtTextureId();
+        header.textureIds[2] = generator->getStoneTextureId();
+        std::vector<uint8_t> delta(sizeof(header));
+        std::memcpy(delta.data(), &header, sizeof(header));
+        if (!chunk.encodeDelta(baseline, full.size(), delta)) return full;
+        return std::string(delta.begin(), delta.end());
+    }
+
+    // Decode a region entry written by encodeStoredChunk
+    static bool decodeStoredChunk(Chunk& chunk, const uint8_t* data, size_t size) {
+        ChunkDeltaHeader header{};
+        if (size < sizeof(header)) return chunk.loadFromMemory(data, size);
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != CHUNK_DELTA_MAGIC) return chunk.loadFromMemory(data, size);
+        if (header.version != CHUNK_DELTA_VERSION || !(header.coord == chunk.getCoordinate())) return false;
+
+        TerrainGenerator baseline(header.textureIds[0], header.textureIds[1], header.textureIds[2]);
+        baseline.setSeed(header.seed);
+        baseline.setFrequency(header.frequency);
+        baseline.setOctaves(header.octaves);
+        baseline.generateChunk(&chunk);
+        return chunk.applyDelta(data + sizeof(header), size - sizeof(header));
+    }
+
+    // Chunk as last written to disk, found through its manifest entry: the region
+    // entry, else a chunk file from before regions. Null if neither exists or the
+    // data is unreadable.
+    static std::unique_ptr<Chunk> readStoredChunk(const Chunk::ChunkCoord& coord, RegionStore& chunkRegions, const WorldManifest::Entry& stored,
+                                                  const std::string& legacyFilePath, StreamingStats* stats = nullptr) {
+        if (stored.flags & WorldManifest::EMPTY) return std::make_unique<Chunk>(coord);
+
+        // Both files are decoded straight out of their memory mappings
+        StreamingStats::Timer timer;
+        auto chunk = std::make_unique<Chunk>(coord);
+        RegionFile::View view;
+        if (stored.size != 0 && chunkRegions.read(coord.x, coord.y, coord.z, view)) {
+            if (view.size != stored.size || WorldManifest::checksum(view.data, view.size) != stored.checksum) {
+                LOG("ERROR: Chunk " + coordString(coord) + " does not match its checksum in the world manifest");
+                return nullptr;
+            }
+            if (stats) stats->record(StreamingStats::Metric::Read, timer.lap());
+            if (!decodeStoredChunk(*chunk, view.data, view.size)) {
+                LOG("Failed to load chunk from region: " + coordString(coord));
+                return nullptr;
+            }
+            if (stats) stats->record(StreamingStats::Metric::Decode, timer.lap());
+            LOG("Loaded chunk from region: " + coordString(coord));
+            return chunk;
+        }
+
+        // Saved before region files; the next save moves it into its region
+        if (!(stored.flags & WorldManifest::LEGACY_FILE)) return nullptr;
+        MappedFile file(legacyFilePath);
+        if (!file.isOpen()) return nullptr;
+        file.adviseAccess(MappedFile::Access::Sequential);
+        if (stats) stats->record(StreamingStats::Metric::Read, timer.lap());
+        if (!chunk->loadFromMemory(file.data(), file.size())) {
+            LOG("Failed to load chunk from file: " + legacyFilePath);
+            return nullptr;
+        }
+        if (stats) stats->record(StreamingStats::Metric::Decode, timer.lap());
+        LOG("Loaded chunk from disk: " + legacyFilePath);
+        return chunk;
+    }
+
+    // Chunk and mesh cache writes done by a background writer. A chunk queued again
+    // before it was written keeps only its newest snapshot, and loads look here
+    // first so they never read an older copy back from disk. Journal compaction
+    // queues edits to fold into chunks that are not loaded.
+    struct SaveQueue {
+        SaveQueue(RegionStore& chunkRegions, RegionStore& meshRegions, WorldManifest& manifest, SharedGenerator& generator)
+            : chunkRegions(chunkRegions), meshRegions(meshRegions), manifest(manifest), generator(generator) {}
+        ~SaveQueue() { flush(); }
+
+        struct PendingSave {
+            std::shared_ptr<const Chunk> chunk;   // Voxels to encode; null to start from the stored chunk
+            std::vector<EditJournal::Edit> edits; // Applied on top before encoding
+            std::string legacyFilePath;           // Removed once the chunk is in its region
+            std::string meshCache;                // Encoded mesh cache; empty if none is queued
+
+            bool hasChunk() const { return chunk || !edits.empty(); }
+        };
+
+        // A snapshot of a live chunk already holds every journaled edit of it
+        void saveChunk(const Chunk::ChunkCoord& coord, std::shared_ptr<const Chunk> chunk, std::string legacyFilePath) {
+            bool schedule;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                PendingSave& save = queued[coord];
+                schedule = !save.hasChunk() && save.meshCache.empty();
+                save.chunk = std::move(chunk);
+                save.edits.clear();
+                save.legacyFilePath = std::move(legacyFilePath);
+            }
+            if (schedule) writer.submit([this, coord] { writeNext(coord); });
+        }
+
+        // Fold edits into the chunk on disk (or the snapshot already queued)
+        void saveEdits(const Chunk::ChunkCoord& coord, const std::vector<EditJournal::Edit>& edits, std::string legacyFilePath) {
+            bool schedule;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                PendingSave& save = queued[coord];
+                schedule = !save.hasChunk() && save.meshCache.empty();
+                save.edits.insert(save.edits.end(), edits.begin(), edits.end());
+                save.legacyFilePath = std::move(legacyFilePath);
+            }
+            if (schedule) writer.submit([this, coord] { writeNext(coord); });
+        }
+
+        void saveMeshCache(const Chunk::ChunkCoord& coord, std::string meshCache) {
+            bool schedule;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                PendingSave& save = queued[coord];
+                schedule = !save.hasChunk() && save.meshCache.empty();
+                save.meshCache = std::move(meshCache);
+            }
+            if (schedule) writer.submit([this, coord] { writeNext(coord); });
+        }
+
+        // Run done(ok) on the writer once everything queued before it is written;
+        // ok is false if any write failed in between
+        void barrier(std::function<void(bool)> done) {
+            size_t failuresBefore;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                failuresBefore = writeFailures;
+                ++activeWrites;
+            }
+            writer.submit([this, failuresBefore, done = std::move(done)] {
+                size_t failures;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failures = writeFailures;
+                }
+                done(failures == failuresBefore);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --activeWrites;
+                }
+                idle.notify_all();
+            });
+        }
+
+        // The newest voxels saved for a chunk if they may not be on disk yet
+        std::shared_ptr<const Chunk> pendingChunk(const Chunk::ChunkCoord& coord) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = queued.find(coord);
+            if (it != queued.end() && it->second.chunk) return it->second.chunk;
+            auto writingIt = writing.find(coord);
+            return (writingIt != writing.end()) ? writingIt->second : nullptr;
+        }
+
+        // Barrier: returns once everything queued so far is on disk
+        void flush() {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this] { return queued.empty() && activeWrites == 0; });
+        }
+
+        // Drop queued saves and wait for the one being written, e.g. before
+        // deleting the world
+        void cancel() {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.clear();
+            idle.wait(lock, [this] { return activeWrites == 0; });
+        }
+
+        size_t pendingCount() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return queued.size() + activeWrites;
+        }
+
+    private:
+        RegionStore& chunkRegions;
+        RegionStore& meshRegions;
+        WorldManifest& manifest;
+        SharedGenerator& generator; // Base for edits to chunks never saved, and for deltas
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::unordered_map<Chunk::ChunkCoord, PendingSave> queued;
+        std::unordered_map<Chunk::ChunkCoord, std::shared_ptr<const Chunk>> writing;
+        size_t activeWrites = 0;
+        size_t writeFailures = 0;
+        ThreadPool writer{1}; // One writer keeps saves of a chunk in order
+
+        void writeNext(const Chunk::ChunkCoord& coord) {
+            PendingSave save;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = queued.find(coord);
+                if (it == queued.end()) return; // Cancelled
+                save = std::move(it->second);
+                queued.erase(it);
+                if (save.chunk) writing[coord] = save.chunk;
+                ++activeWrites;
+            }
+
+            bool failed = false;
+            bool writes = save.hasChunk() || !save.meshCache.empty();
+            if (writes) manifest.beginWrite();
+            if (save.hasChunk()) {
+                std::shared_ptr<const Chunk> chunk = save.chunk;
+                if (!save.edits.empty()) {
+                    WorldManifest::Entry stored;
+                    manifest.find(coord, stored);
+                    std::unique_ptr<Chunk> edited = chunk ? chunk->createSnapshot() : readStoredChunk(coord, chunkRegions, stored, save.legacyFilePath);
+                    if (!edited) {
+                        // Never saved: the edits apply to generated terrain
+                        edited = std::make_unique<Chunk>(coord);
+                        if (std::shared_ptr<const TerrainGenerator> terrain = generator.get()) terrain->generateChunk(edited.get());
+                    }
+                    EditJournal::apply(*edited, save.edits);
+                    chunk = std::move(edited);
+                }
+                std::shared_ptr<const TerrainGenerator> terrain = generator.get();
+                std::string bytes = encodeStoredChunk(*chunk, terrain.get());
+                if (chunkRegions.write(coord.x, coord.y, coord.z, bytes.data(), bytes.size())) {
+                    manifest.setChunk(coord, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), chunk->empty());
+                    // The region copy supersedes a chunk file saved before regions
+                    std::error_code error;
+                    std::filesystem::remove(save.legacyFilePath, error);
+                } else {
+                    LOG("ERROR: Could not save chunk " + coordString(coord) + " to its region file");
+                    failed = true;
+                }
+            }
+            if (!save.meshCache.empty()) {
+                if (meshRegions.write(coord.x, coord.y, coord.z, save.meshCache.data(), save.meshCache.size())) {
+                    manifest.setMeshCached(coord);
+                } else {
+                    LOG("Failed to write mesh cache: " + coordString(coord));
+                }
+            }
+            if (writes) manifest.endWrite();
+
+            // Saved once the queue drains, so a burst of saves writes it once
+            bool drained;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                drained = queued.empty();
+            }
+            if (drained) manifest.save();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                writing.erase(coord);
+                --activeWrites;
+                if (failed) ++writeFailures;
+            }
+            idle.notify_all();
+        }
+    };
+
+    struct LoadQueue;
+
+    // Read, or generate, a chunk with its mesh cache and physics surface. Touches
+    // only the load queue's thread-safe state, so it runs on the loader threads
+    // as well as inline.
+    static LoadResult readChunk(const LoadRequest& request, LoadQueue& queue) {
+        LoadResult result;
+        result.coord = request.coord;
+        result.epoch = request.epoch;
+        result.requested = request.requested;
+        const Chunk::ChunkCoord& coord = request.coord;
+        StreamingStats& stats = *queue.stats;
+
+        // Journaled edits are taken before reading the chunk: compaction may write
+        // them into the chunk file and drop them meanwhile, and replaying edits the
+        // file already has is harmless
+        std::vector<EditJournal::Edit> edits = queue.journal.editsFor(coord);
+        // Recently unloaded chunks are as new as anything queued for saving
+        std::string cachedMeshes;
+        WorldManifest::Entry stored;
+        StreamingStats::Timer timer;
+        std::unique_ptr<Chunk> chunk = queue.memoryCache.take(coord, cachedMeshes, result.generated);
+        if (chunk) {
+            stats.record(StreamingStats::Metric::Decode, timer.lap());
+        } else if (std::shared_ptr<const Chunk> unsaved = queue.saves.pendingChunk(coord)) {
+            // Saved but not written yet, so the copy on disk is older
+            chunk = unsaved->createSnapshot();
+            stats.record(StreamingStats::Metric::Decode, timer.lap());
+        } else if (queue.manifest.find(coord, stored) && stored.hasChunk()) {
+            // Looked up after the save queue, which updates the manifest before
+            // letting go of a chunk
+            chunk = readStoredChunk(coord, queue.chunkRegions, stored, request.legacyFilePath, &stats);
+            timer.lap();
+        }
+        if (!chunk) {
+            // Never saved; journaled edits still apply on top
+            std::shared_ptr<const TerrainGenerator> terrain = queue.generator.get();
+            if (!terrain && edits.empty()) return result;
+            chunk = std::make_unique<Chunk>(coord);
+            if (terrain) {
+                terrain->generateChunk(chunk.get());
+                result.generated = true;
+                stats.record(StreamingStats::Metric::Generate, timer.lap());
+            }
+        }
+        EditJournal::apply(*chunk, edits);
+        timer.lap();
+
+        // Only surface voxels take part in physics
+        glm::vec3 chunkWorldPos = chunk->getWorldPosition();
+        chunk->forEachSurfaceVoxel([&](int x, int y, int z) {
+            glm::vec3 voxelWorldPos = chunkWorldPos + glm::vec3(x, y, z) * Chunk::VOXEL_SIZE;
+            result.physicsVoxels.emplace_back(voxelWorldPos, Chunk::VOXEL_SIZE, chunk->getVoxel(x, y, z).type);
+        });
+        stats.record(StreamingStats::Metric::Surface, timer.lap());
+
+        // Neighbors are not linked yet, so every side is checked when they link
+        RegionFile::View view;
+        if (!cachedMeshes.empty()) {
+            result.meshCached = chunk->loadMeshCache(reinterpret_cast<const uint8_t*>(cachedMeshes.data()), cachedMeshes.size());
+            stats.record(StreamingStats::Metric::MeshCache, timer.lap());
+        } else if (!chunk->empty() && !result.generated && queue.manifest.find(coord, stored) &&
+                   (stored.flags & WorldManifest::MESH_CACHED) && queue.meshRegions.read(coord.x, coord.y, coord.z, view)) {
+            result.meshCached = chunk->loadMeshCache(view.data, view.size);
+            stats.record(StreamingStats::Metric::MeshCache, timer.lap());
+        }
+        result.chunk = std::move(chunk);
+        return result;
+    }
+
+    // Pending chunk loads shared with the loader threads. Requests are picked by
+    // priority when a loader becomes free, so reprioritizing is just rewriting
+    // priorities; results come back through a lock-free queue. The region stores
+    // live here too since loaders read them while the main thread saves.
+    struct LoadQueue {
+        explicit LoadQueue(const std::string& worldPath)
+            : chunkRegions(worldPath, ".vxr"), meshRegions(worldPath, ".vxm"), manifest(worldPath), journal(worldPath) {
+            if (!manifest.wasLoaded()) rebuildManifest(worldPath);
+        }
+
+        RegionStore chunkRegions;
+        RegionStore meshRegions;
+        WorldManifest manifest; // What is in the regions, so loads of chunks not on disk touch no files
+        EditJournal journal;
+        ChunkCache memoryCache{DEFAULT_MEMORY_CACHE_BYTES};
+        SharedGenerator generator;
+        SaveQueue saves{chunkRegions, meshRegions, manifest, generator}; // Declared after what its writes touch
+        std::shared_ptr<StreamingStats> stats = std::make_shared<StreamingStats>(); // Shared with the mesh jobs
+        std::mutex mutex;
+        std::vector<LoadRequest> requests;
+        MpscQueue<LoadResult> finished;
+        ThreadPool loaders{2}; // Disk bound; a couple of threads keep the drive busy
+
+        // One submitted task per request; a task whose request was cancelled finds
+        // nothing (or someone else's request) and that is fine
+        void loadNext() {
+            LoadRequest request;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (requests.empty()) return;
+                auto best = std::min_element(requests.begin(), requests.end(),
+                    [](const LoadRequest& a, const LoadRequest& b) { return a.priority < b.priority; });
+                request = std::move(*best);
+                *best = std::move(requests.back());
+                requests.pop_back();
+            }
+            std::chrono::duration<float, std::milli> waited = std::chrono::steady_clock::now() - request.requested;
+            stats->record(StreamingStats::Metric::QueueWait, waited.count());
+            finished.push(readChunk(request, *this));
+        }
+
+        // Index a world saved without a manifest from its region headers and the
+        // chunk files left from before regions
+        void rebuildManifest(const std::string& worldPath) {
+            chunkRegions.forEachChunk([this](int x, int y, int z, const RegionFile::View& view) {
+                manifest.setChunk(Chunk::ChunkCoord{x, y, z}, view.data, view.size, Chunk::isEmptyEncoding(view.data, view.size));
+            });
+            meshRegions.forEachChunk([this](int x, int y, int z, const RegionFile::View&) {
+                manifest.setMeshCached(Chunk::ChunkCoord{x, y, z});
+            });
+            std::error_code error;
+            for (const auto& entry : std::filesystem::directory_iterator(worldPath, error)) {
+                Chunk::ChunkCoord coord{};
+                int length = 0;
+                std::string name = entry.path().filename().string();
+                if (entry.is_regular_file() && std::sscanf(name.c_str(), "chunk_%d_%d_%d.dat%n", &coord.x, &coord.y, &coord.z, &length) == 3 &&
+                    length == static_cast<int>(name.size())) {
+                    manifest.setLegacyFile(coord);
+                }
+            }
+            LOG("Rebuilt world manifest: " + std::to_string(manifest.chunkCount()) + " chunks on disk");
+        }
+    };
+
+    // A generateWorld run. Workers generate and encode chunks in parallel and hand
+    // them to a single writer; at most maxInFlight chunks are between the start of
+    // their generation and their write, which bounds the memory used whatever the
+    // world size. Held by pointer so it can be replaced and cancelled; the pools
+    // are declared last, workers after the writer they feed, so they are joined
+    // before the state they use goes away.
+    struct WorldGeneration {
+        WorldGeneration(RegionStore& chunkRegions, WorldManifest& manifest, std::shared_ptr<const TerrainGenerator> generator,
+                        const std::vector<Chunk::ChunkCoord>& coords)
+            : chunkRegions(chunkRegions), manifest(manifest), generator(std::move(generator)), total(coords.size()),
+              maxInFlight(ThreadPool::defaultThreadCount() * 2) {
+            for (const Chunk::ChunkCoord& coord : coords) {
+                workers.submit([this, coord] { generate(coord); });
+            }
+        }
+        ~WorldGeneration() { cancel(); }
+
+        RegionStore& chunkRegions;
+        WorldManifest& manifest;
+        std::shared_ptr<const TerrainGenerator> generator;
+        const size_t total;
+        std::atomic<size_t> generated{0};
+        std::atomic<size_t> written{0};
+        std::atomic<bool> cancelled{false};
+
+        bool running() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return done < total;
+        }
+
+        void cancel() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cancelled = true;
+            }
+            changed.notify_all();
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return done == total; });
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t inFlight = 0;
+        size_t done = 0; // Chunks written, failed or skipped by a cancel
+        const size_t maxInFlight;
+        ThreadPool writer{1};
+        ThreadPool workers;
+
+        void generate(const Chunk::ChunkCoord& coord) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return inFlight < maxInFlight || cancelled; });
+                if (cancelled) {
+                    ++done;
+                    changed.notify_all();
+                    return;
+                }
+                ++inFlight;
+            }
+
+            // Stored in full, not as a delta, so loading it is a decode rather
+            // than a second generation
+            std::ostringstream out;
+            bool empty;
+            {
+                auto chunk = std::make_unique<Chunk>(coord);
+                if (generator) generator->generateChunk(chunk.get());
+                chunk->saveToBinary(out);
+                empty = chunk->empty();
+            }
+            auto bytes = std::make_shared<std::string>(std::move(out).str());
+            ++generated;
+
+            writer.submit([this, coord, bytes, empty] {
+                if (!cancelled) {
+                    manifest.beginWrite();
+                    if (chunkRegions.write(coord.x, coord.y, coord.z, bytes->data(), bytes->size())) {
+                        manifest.setChunk(coord, reinterpret_cast<const uint8_t*>(bytes->data()), bytes->size(), empty);
+                        ++written;
+                    } else {
+                        LOG("ERROR: Could not save chunk " + coordString(coord) + " to its region file");
+                    }
+                    manifest.endWrite();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --inFlight;
+                    ++done;
+                }
+                changed.notify_all();
+            });
+        }
+    };
+
+    // Log how a world generation ended and resume streaming
+    void finishWorldGeneration() {
+        LOG(std::string(worldGeneration->cancelled ? "World generation cancelled after " : "New world generation complete: ") +
+            std::to_string(worldGeneration->written) + " of " + std::to_string(worldGeneration->total) + " chunks written");
+        worldGeneration.reset();
+        loadQueue->manifest.save();
+        loadSetValid = false;
+    }
+
+    std::unique_ptr<MeshQueue> meshQueue;
+    std::unordered_map<Chunk::ChunkCoord, uint64_t> meshJobsInFlight; // Latest job per chunk
+    std::vector<MeshResult> readyMeshes;
+    std::vector<Chunk::SectionMesh> spareSectionMeshes;
+    uint64_t nextMeshJobId = 0;
+    size_t meshIntegrationsPerFrame = 8;
+
+    std::unique_ptr<LoadQueue> loadQueue;
+    std::unique_ptr<WorldGeneration> worldGeneration;   // Writes into loadQueue's regions
+    FlatHashSet<Chunk::ChunkCoord> pendingLoads; // Requested or being read
+    std::deque<LoadResult> loadedResults;               // Read, waiting to be installed
+    uint64_t loadEpoch = 0;                             // Bumped to discard loads in flight
+    Chunk::ChunkCoord streamCenter{};                    // Center of the current load set
+    std::vector<Chunk::ChunkCoord> loadOffsets;         // sphereOffsets(loadSetRadius)
+    int loadSetRadius = -1;
+    int loadSetUnloadRadius = -1;
+    bool loadSetValid = false;                          // False until the next update requests every chunk
+    Chunk::ChunkCoord prefetchCenter{};                 // Camera's predicted chunk; streamCenter when still
+    float prefetchSeconds = 1.0f;
+    glm::vec3 cameraVelocity{0.0f};                     // Smoothed, world units per second
+    glm::vec3 lastCameraPosition{0.0f};
+    std::chrono::steady_clock::time_point lastCameraTime;
+    bool hasCameraSample = false;
+    float loadBudgetMs = 4.0f;
+    static constexpr size_t PHYSICS_INSERT_BATCH = 256; // Octree inserts between budget checks
+    static constexpr float PREFETCH_PRIORITY = 1.0e4f;  // Added to prefetch priorities, which are distances in chunks
+    static constexpr float MAX_PREFETCH_CHUNKS = 16.0f; // Longest lookahead, bounding the prefetch set
+    static constexpr float VELOCITY_SMOOTHING_SECONDS = 0.25f;
+    static constexpr float MAX_VELOCITY_SAMPLE_SECONDS = 0.5f;
+    static constexpr size_t JOURNAL_COMPACT_EDITS = 1 << 16; // Journaled edits before they are written into chunks
+    static constexpr size_t DEFAULT_MEMORY_CACHE_BYTES = size_t(256) << 20;
+
+    static int distanceSquared(const Chunk::ChunkCoord& a, const Chunk::ChunkCoord& b) {
+        int dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Squared distance in chunks from a chunk to the segment between two others
+    static float segmentDistanceSquared(const Chunk::ChunkCoord& coord, const Chunk::ChunkCoord& a, const Chunk::ChunkCoord& b) {
+        glm::vec3 p(coord.x, coord.y, coord.z), start(a.x, a.y, a.z), segment = glm::vec3(b.x, b.y, b.z) - start;
+        float lengthSquared = glm::length2(segment);
+        float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(p - start, segment) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+        return glm::length2(p - (start + segment * t));
+    }
+
+    // Once per update, so depth percentiles are over frames
+    void sampleQueueDepths() {
+        StreamingStats& stats = *loadQueue->stats;
+        size_t requests;
+        {
+            std::lock_guard<std::mutex> lock(loadQueue->mutex);
+            requests = loadQueue->requests.size();
+        }
+        stats.record(StreamingStats::Metric::LoadRequests, static_cast<float>(requests));
+        stats.record(StreamingStats::Metric::LoadsPending, static_cast<float>(pendingLoads.size()));
+        stats.record(StreamingStats::Metric::InstallQueue, static_cast<float>(loadedResults.size()));
+        stats.record(StreamingStats::Metric::MeshJobs, static_cast<float>(meshJobsInFlight.size()));
+        stats.record(StreamingStats::Metric::PendingSaves, static_cast<float>(loadQueue->saves.pendingCount()));
+    }
+
+    // Within the unload radius of the camera's chunk or of its path to the
+    // predicted chunk; loaded chunks outside are unloaded and loads discarded
+    bool inUnloadRange(const Chunk::ChunkCoord& coord) const {
+        int unloadRadiusSquared = unloadRadius * unloadRadius;
+        if (distanceSquared(coord, streamCenter) <= unloadRadiusSquared) return true;
+        return !(prefetchCenter == streamCenter) && segmentDistanceSquared(coord, streamCenter, prefetchCenter) <= unloadRadiusSquared;
+    }
+
+    // Chunks only wanted by the prefetch load after every chunk in range
+    float requestPriority(const Chunk::ChunkCoord& coord, const glm::vec3& cameraPosition, const glm::vec3& viewDirection) const {
+        float priority = loadPriority(coord, cameraPosition, viewDirection);
+        if (distanceSquared(coord, streamCenter) > loadSetRadius * loadSetRadius) priority += PREFETCH_PRIORITY;
+        return priority;
+    }
+
+    // Follow the camera's velocity from its position each update. Long gaps
+    // between updates and jumps past the unload radius (teleports, world loads)
+    // reset it rather than predict from them.
+    void updateCameraVelocity(const glm::vec3& cameraPosition) {
+        auto now = std::chrono::steady_clock::now();
+        if (hasCameraSample) {
+            float elapsed = std::chrono::duration<float>(now - lastCameraTime).count();
+            if (elapsed <= 0.0f) return;
+            glm::vec3 moved = cameraPosition - lastCameraPosition;
+            float chunkWorldSize = Chunk::CHUNK_SIZE * Chunk::VOXEL_SIZE;
+            if (elapsed > MAX_VELOCITY_SAMPLE_SECONDS || glm::length(moved) > unloadRadius * chunkWorldSize) {
+                cameraVelocity = glm::vec3(0.0f);
+            } else {
+                float blend = std::min(1.0f, elapsed / VELOCITY_SMOOTHING_SECONDS);
+                cameraVelocity += (moved / elapsed - cameraVelocity) * blend;
+            }
+        }
+        lastCameraPosition = cameraPosition;
+        lastCameraTime = now;
+        hasCameraSample = true;
+    }
+
+    // Distance to the chunk center in chunks, up to doubled for chunks behind the camera
+    static float loadPriority(const Chunk::ChunkCoord& coord, const glm::vec3& cameraPosition, const glm::vec3& viewDirection) {
+        float chunkWorldSize = Chunk::CHUNK_SIZE * Chunk::VOXEL_SIZE;
+        glm::vec3 toChunk = (glm::vec3(coord.x, coord.y, coord.z) + glm::vec3(0.5f)) * chunkWorldSize - cameraPosition;
+        float distance = glm::length(toChunk) / chunkWorldSize;
+        if (distance < 1e-4f || glm::length2(viewDirection) < 1e-8f) return distance;
+        float facing = glm::dot(toChunk / (distance * chunkWorldSize), glm::normalize(viewDirection));
+        return distance * (1.5f - 0.5f * facing);
+    }
+
+    // Install chunks finished by the loaders, oldest first, within the load budget.
+    // Octree inserts dominate, so a chunk's physics voxels go in over several
+    // frames if needed and the chunk is installed once they are all in.
+    void installLoadedChunks() {
+        loadQueue->finished.popAll(loadedResults);
+        auto start = std::chrono::steady_clock::now();
+        auto overBudget = [&] {
+            std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() >= loadBudgetMs;
+        };
+
+        while (!loadedResults.empty()) {
+            LoadResult& result = loadedResults.front();
+            if (result.physicsInserted == 0) {
+                if (result.epoch != loadEpoch) { // Requested before clearWorld
+                    loadedResults.pop_front();
+                    continue;
+                }
+                // Loaded inline meanwhile (e.g. by an edit), or no longer wanted
+                if (loadedChunks.count(result.coord) || !inUnloadRange(result.coord)) {
+                    pendingLoads.erase(result.coord);
+                    loadedResults.pop_front();
+                    continue;
+                }
+            }
+
+            while (result.physicsInserted < result.physicsVoxels.size()) {
+                StreamingStats::Timer batchTimer;
+                size_t end = std::min(result.physicsVoxels.size(), result.physicsInserted + PHYSICS_INSERT_BATCH);
+                for (size_t i = result.physicsInserted; i < end; ++i) {
+                    const Chunk::PhysicsVoxelData& physicsData = result.physicsVoxels[i];
+                    const glm::vec3& p = physicsData.worldPosition;
+                    physicsOctree.insert(Vector3(p.x, p.y, p.z), physicsData);
+                }
+                result.physicsInserted = end;
+                result.installMs += batchTimer.lap();
+                if (overBudget()) return;
+            }
+
+            pendingLoads.erase(result.coord);
+            if (loadedChunks.count(result.coord)) {
+                // Loaded inline while its physics was going in; undo that part
+                for (const Chunk::PhysicsVoxelData& physicsData : result.physicsVoxels) {
+                    const glm::vec3& p = physicsData.worldPosition;
+                    physicsOctree.remove(Vector3(p.x, p.y, p.z), [&](const Chunk::PhysicsVoxelData& data) {
+                        return data.worldPosition == physicsData.worldPosition && data.type == physicsData.type;
+                    });
+                }
+            } else {
+                installChunk(std::move(result));
+            }
+            loadedResults.pop_front();
+            if (overBudget()) return;
+        }
+    }
+
+    // Drop every queued request and ignore results of loads already running
+    void cancelPendingLoads() {
+        {
+            std::lock_guard<std::mutex> lock(loadQueue->mutex);
+            loadQueue->requests.clear();
+        }
+        pendingLoads.clear();
+        loadedResults.clear();
+        ++loadEpoch;
+        loadSetValid = false; // Request the whole load sphere again
+    }
+
+    // Chunk offsets within radius of the center, nearest first
+    static std::vector<Chunk::ChunkCoord> sphereOffsets(int radius) {
+        std::vector<Chunk::ChunkCoord> offsets;
+        for (int x = -radius; x <= radius; ++x) {
+            for (int y = -radius; y <= radius; ++y) {
+                for (int z = -radius; z <= radius; ++z) {
+                    if (x * x + y * y + z * z <= radius * radius) offsets.push_back({x, y, z});
+                }
+            }
+        }
+        Chunk::ChunkCoord origin{0, 0, 0};
+        std::stable_sort(offsets.begin(), offsets.end(), [&](const Chunk::ChunkCoord& a, const Chunk::ChunkCoord& b) {
+            return distanceSquared(a, origin) < distanceSquared(b, origin);
+        });
+        return offsets;
+    }
+
+    // Request the chunks that entered the load sphere and unload those that left
+    // the unload sphere. Chunks still inside the previous load sphere were
+    // requested back then and are loaded, missing or pending, so only the
+    // difference between the two spheres needs looking up. While the camera
+    // moves, every chunk within loadRadius of its path to the predicted chunk is
+    // wanted too; those prefetches load nearest first, in the order the camera
+    // will reach them.
+    void updateLoadSet(const Chunk::ChunkCoord& center, const Chunk::ChunkCoord& predicted,
+                       const glm::vec3& cameraPosition, const glm::vec3& viewDirection) {
+        if (loadOffsets.empty() || loadSetRadius != loadRadius) loadOffsets = sphereOffsets(loadRadius);
+        bool incremental = loadSetValid && loadSetRadius == loadRadius && unloadRadius >= loadRadius;
+        Chunk::ChunkCoord previousCenter = streamCenter;
+        streamCenter = center;
+        prefetchCenter = predicted;
+        loadSetRadius = loadRadius;
+        loadSetUnloadRadius = unloadRadius;
+        loadSetValid = true;
+
+        int loadRadiusSquared = loadRadius * loadRadius;
+        bool prefetching = !(predicted == center);
+        std::vector<LoadRequest> newRequests;
+        auto request = [&](const Chunk::ChunkCoord& coord) {
+            if (!loadedChunks.contains(coord) && !missingChunks.contains(coord) && pendingLoads.insert(coord).second) {
+                newRequests.push_back(LoadRequest{coord, requestPriority(coord, cameraPosition, viewDirection), loadEpoch, getChunkFilePath(coord)});
+            }
+        };
+        for (const Chunk::ChunkCoord& offset : loadOffsets) {
+            Chunk::ChunkCoord coord{center.x + offset.x, center.y + offset.y, center.z + offset.z};
+            if (incremental && distanceSquared(coord, previousCenter) <= loadRadiusSquared) continue;
+            request(coord);
+        }
+        if (prefetching) {
+            for (int x = std::min(center.x, predicted.x) - loadRadius; x <= std::max(center.x, predicted.x) + loadRadius; ++x) {
+                for (int y = std::min(center.y, predicted.y) - loadRadius; y <= std::max(center.y, predicted.y) + loadRadius; ++y) {
+                    for (int z = std::min(center.z, predicted.z) - loadRadius; z <= std::max(center.z, predicted.z) + loadRadius; ++z) {
+                        Chunk::ChunkCoord coord{x, y, z};
+                        if (distanceSquared(coord, center) > loadRadiusSquared &&
+                            segmentDistanceSquared(coord, center, predicted) <= loadRadiusSquared) request(coord);
+                    }
+                }
+            }
+        }
+
+        // Drop requests that fell out of range, including prefetches the camera
+        // turned away from, reprioritize the rest for the new camera and hand the
+        // new ones to the loaders
+        {
+            std::lock_guard<std::mutex> lock(loadQueue->mutex);
+            auto& requests = loadQueue->requests;
+            for (size_t i = 0; i < requests.size();) {
+                const Chunk::ChunkCoord& coord = requests[i].coord;
+                if (distanceSquared(coord, center) > loadRadiusSquared &&
+                    (!prefetching || segmentDistanceSquared(coord, center, predicted) > loadRadiusSquared)) {
+                    pendingLoads.erase(coord);
+                    requests[i] = std::move(requests.back());
+                    requests.pop_back();
+                    continue;
+                }
+                requests[i].priority = requestPriority(coord, cameraPosition, viewDirection);
+                ++i;
+            }
+            for (LoadRequest& request : newRequests) {
+                requests.push_back(std::move(request));
+            }
+        }
+        LoadQueue* queue = loadQueue.get();
+        for (size_t i = 0; i < newRequests.size(); ++i) {
+            queue->loaders.submit([queue] { queue->loadNext(); });
+        }
+
+        // Unload distant chunks, keeping those near where the camera is heading
+        std::vector<Chunk::ChunkCoord> chunksToUnload;
+        for (const auto& [coord, chunk] : loadedChunks) {
+            if (!inUnloadRange(coord)) {
+                chunksToUnload.push_back(coord);
+            }
+        }
+        for (const auto& coord : chunksToUnload) {
+            unloadChunk(coord);
+        }
+    }
+
+    // Make a read chunk live: physics, neighbor links and the loaded map
+    Chunk* installChunk(LoadResult result) {
+        if (!result.chunk) {
+            missingChunks.insert(result.coord);
+            return nullptr;
+        }
+        StreamingStats::Timer timer;
+
+        for (size_t i = result.physicsInserted; i < result.physicsVoxels.size(); ++i) {
+            const Chunk::PhysicsVoxelData& physicsData = result.physicsVoxels[i];
+            const glm::vec3& p = physicsData.worldPosition;
+            physicsOctree.insert(Vector3(p.x, p.y, p.z), physicsData);
+        }
+        if (result.meshCached) {
+            LOG("Loaded cached mesh: " + coordString(result.coord));
+        }
+
+        Chunk* ptr = result.chunk.get();
+        loadedChunks[result.coord] = std::move(result.chunk);
+        missingChunks.erase(result.coord);
+        if (result.generated) generatedChunks.insert(result.coord);
+        linkNeighbors(ptr);
+
+        StreamingStats& stats = *loadQueue->stats;
+        stats.record(StreamingStats::Metric::Install, result.installMs + timer.lap());
+        std::chrono::duration<float, std::milli> total = std::chrono::steady_clock::now() - result.requested;
+        stats.record(StreamingStats::Metric::LoadTotal, total.count());
+        return ptr;
+    }
    
     // Convert world position to chunk coordinate
     Chunk::ChunkCoord worldToChunkCoord(const glm::vec3& worldPos) const {
@@ -386,52 +1526,22 @@ private:
         );
     }
     
-    // Get file path for chunk
+    // Get file path for chunk, as saved before region files
     std::string getChunkFilePath(const Chunk::ChunkCoord& coord) const {
         return worldDataPath + "/chunk_" + 
                std::to_string(coord.x) + "_" + 
                std::to_string(coord.y) + "_" + 
                std::to_string(coord.z) + ".dat";
     }
+
+    static std::string coordString(const Chunk::ChunkCoord& coord) {
+        return std::to_string(coord.x) + "," + std::to_string(coord.y) + "," + std::to_string(coord.z);
+    }
     
-    // Load chunk from disk or create new
+    // Load chunk from disk on the calling thread; nullptr if the chunk is not on disk
     Chunk* loadChunk2(const Chunk::ChunkCoord& coord) {
-        auto chunk = std::make_unique<Chunk>(coord);
-        std::string filePath = getChunkFilePath(coord);
-        
-        if (std::filesystem::exists(filePath)) {
-            std::ifstream file(filePath, std::ios::binary);
-            if (file.is_open() && chunk->loadFromBinary(file)) {
-                LOG("Loaded chunk from disk: " + filePath);
-            } else {
-                LOG("Failed to load chunk from file: " + filePath);
-                return nullptr;
-            }
-            file.close();
-        } else {
-            missingChunks.insert(coord);
-            return nullptr;
-        }
-
-        // Populate physicsOctree with solid voxels
-        glm::vec3 chunkWorldPos = chunk->getWorldPosition();
-        for (int x = 0; x < Chunk::CHUNK_SIZE; ++x) {
-            for (int y = 0; y < Chunk::CHUNK_SIZE; ++y) {
-                for (int z = 0; z < Chunk::CHUNK_SIZE; ++z) {
-                    // Only insert physics data for surface voxels
-                    if (chunk->isSurfaceVoxel(x, y, z)) {
-                        glm::vec3 voxelWorldPos = chunkWorldPos + glm::vec3(x, y, z) * Chunk::VOXEL_SIZE;
-                        Chunk::PhysicsVoxelData physicsData(voxelWorldPos, Chunk::VOXEL_SIZE, chunk->getVoxel(x, y, z).type);
-                        physicsOctree.insert(Vector3(voxelWorldPos.x, voxelWorldPos.y, voxelWorldPos.z), physicsData);
-                    }
-                }
-            }
-        }
-        
-        Chunk* ptr = chunk.get();
-        loadedChunks[coord] = std::move(chunk);
-        missingChunks.erase(coord);
-        return ptr;
+        LoadRequest request{coord, 0.0f, loadEpoch, getChunkFilePath(coord)};
+        return installChunk(readChunk(request, *loadQueue));
     }
 
     // Chunk* loadChunk2(const Chunk::ChunkCoord& coord) {
@@ -505,6 +1615,7 @@ private:
         // Store in loadedChunks map
         Chunk* ptr = chunk.get();
         loadedChunks[coord] = std::move(chunk);
+        linkNeighbors(ptr);
 
         LOG("Created new empty chunk at " 
             + std::to_string(coord.x) + ", " 
@@ -514,14 +1625,48 @@ private:
         return ptr;
     }
 
+    // Connect a newly loaded chunk with its six loaded neighbors. Neighbors that
+    // already have geometry are remeshed so faces against the new chunk get culled,
+    // unless their meshes were already culled against its current border.
+    void linkNeighbors(Chunk* chunk) {
+        const Chunk::ChunkCoord& coord = chunk->getCoordinate();
+        for (int face = 0; face < 6; ++face) {
+            Chunk* neighbor = getChunk({
+                coord.x + Chunk::FACE_OFFSETS[face][0],
+                coord.y + Chunk::FACE_OFFSETS[face][1],
+                coord.z + Chunk::FACE_OFFSETS[face][2]
+            });
+            chunk->setNeighbor(face, neighbor);
+            if (neighbor) {
+                neighbor->setNeighbor(face ^ 1, chunk);
+                chunk->markNeighborDirty(face);
+                neighbor->markNeighborDirty(face ^ 1); // Cached meshes of the new chunk
+            }
+        }
+    }
+
+    // Detach a chunk that is about to be destroyed. Neighbors keep their current
+    // meshes: the faces culled against it sit on the edge of the loaded area.
+    void unlinkNeighbors(Chunk* chunk) {
+        for (int face = 0; face < 6; ++face) {
+            Chunk* neighbor = chunk->getNeighbor(face);
+            if (neighbor) {
+                neighbor->recordDepartingNeighbor(face ^ 1);
+                neighbor->setNeighbor(face ^ 1, nullptr);
+            }
+            chunk->setNeighbor(face, nullptr);
+        }
+    }
+
     // Load chunk (from disk or generate)
     void loadChunk(const Chunk::ChunkCoord& coord) {
         if (loadedChunks.find(coord) != loadedChunks.end()) return;
         loadChunk2(coord);
     }
     
-    // Unload chunk (save first if modified)
-    void unloadChunk(const Chunk::ChunkCoord& coord) {
+    // Unload chunk (save first if modified). keepCopies writes its mesh cache and
+    // keeps it in the memory cache; off when the world is being thrown away.
+    void unloadChunk(const Chunk::ChunkCoord& coord, bool keepCopies = true) {
         auto it = loadedChunks.find(coord);
         if (it == loadedChunks.end()) return;
         
@@ -530,42 +1675,64 @@ private:
             saveChunk(coord, it->second.get());
             modifiedChunks.erase(coord);
         }
+
+        // Encoded while the neighbors are linked, so the border hashes are right
+        std::string meshCache;
+        if (keepCopies && it->second->hasCompleteMeshes() && !meshJobsInFlight.count(coord)) {
+            bool newerThanDisk = it->second->canSaveMeshCache();
+            std::ostringstream out;
+            if (it->second->saveMeshCache(out)) {
+                meshCache = std::move(out).str();
+                // Generated chunks are not on disk, so neither are their meshes
+                if (newerThanDisk && !generatedChunks.contains(coord)) loadQueue->saves.saveMeshCache(coord, meshCache);
+            }
+        }
+        bool generated = generatedChunks.erase(coord) > 0;
         
         // Remove physics voxel data from the octree
         Chunk* chunk = it->second.get();
         glm::vec3 chunkWorldPos = chunk->getWorldPosition();
-        for (int x = 0; x < Chunk::CHUNK_SIZE; ++x) {
-            for (int y = 0; y < Chunk::CHUNK_SIZE; ++y) {
-                for (int z = 0; z < Chunk::CHUNK_SIZE; ++z) {
-                    // Only remove physics data for surface voxels
-                    if (chunk->isSurfaceVoxel(x, y, z)) {
-                        glm::vec3 voxelWorldPos = chunkWorldPos + glm::vec3(x, y, z) * Chunk::VOXEL_SIZE;
-                        // The predicate ensures we remove the correct PhysicsVoxelData if multiple exist at the same position (though for voxels, it should be unique)
-                        physicsOctree.remove(Vector3(voxelWorldPos.x, voxelWorldPos.y, voxelWorldPos.z), 
-                                             [&](const Chunk::PhysicsVoxelData& data){
-                                                 return data.worldPosition == voxelWorldPos && data.type == chunk->getVoxel(x,y,z).type;
-                                             });
-                    }
-                }
-            }
+        // Only remove physics data for surface voxels
+        chunk->forEachSurfaceVoxel([&](int x, int y, int z) {
+            glm::vec3 voxelWorldPos = chunkWorldPos + glm::vec3(x, y, z) * Chunk::VOXEL_SIZE;
+            uint8_t type = chunk->getVoxel(x, y, z).type;
+            // The predicate ensures we remove the correct PhysicsVoxelData if multiple exist at the same position (though for voxels, it should be unique)
+            physicsOctree.remove(Vector3(voxelWorldPos.x, voxelWorldPos.y, voxelWorldPos.z), 
+                                 [&](const Chunk::PhysicsVoxelData& data){
+                                     return data.worldPosition == voxelWorldPos && data.type == type;
+                                 });
+        });
+
+        unlinkNeighbors(chunk);
+        meshJobsInFlight.erase(coord);
+        if (lastHitChunk == chunk) lastHitChunk = nullptr;
+        if (keepCopies) {
+            // Compressed on a loader thread; the chunk is not touched here again
+            std::shared_ptr<const Chunk> departing = std::move(it->second);
+            loadQueue->memoryCache.insert(coord, departing, std::move(meshCache), generated);
+            LoadQueue* queue = loadQueue.get();
+            queue->loaders.submit([queue, coord, departing] { queue->memoryCache.compress(coord, departing); });
         }
-
         loadedChunks.erase(it);
         LOG("Unloaded chunk: " + std::to_string(coord.x) + "," + 
             std::to_string(coord.y) + "," + std::to_string(coord.z));
     }
     
-    // Save chunk to disk
-    void saveChunk(const Chunk::ChunkCoord& coord, Chunk* chunk) {
-        std::string filePath = getChunkFilePath(coord);
-        std::ofstream file(filePath, std::ios::binary);
-        
-        if (file.is_open()) {
-            chunk->saveToBinary(file);
-            file.close();
-        } else {
-            LOG("ERROR: Could not save chunk to " + filePath);
+    // Write the chunk's meshes to the mesh cache if they are complete and not on disk yet
+    void saveMeshCache(const Chunk::ChunkCoord& coord, Chunk* chunk) {
+        if (!chunk->canSaveMeshCache() || meshJobsInFlight.count(coord) || generatedChunks.contains(coord)) return;
+        std::ostringstream out;
+        if (!chunk->saveMeshCache(out)) {
+            LOG("Failed to write mesh cache: " + coordString(coord));
+            return;
         }
+        loadQueue->saves.saveMeshCache(coord, std::move(out).str());
+    }
+
+    // Queue a snapshot of the chunk for the background writer
+    void saveChunk(const Chunk::ChunkCoord& coord, Chunk* chunk) {
+        loadQueue->saves.saveChunk(coord, chunk->createSnapshot(), getChunkFilePath(coord));
+        generatedChunks.erase(coord);
     }
 
     
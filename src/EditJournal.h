@@ -0,0 +1,236 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Chunk.h"
+#include "Logger.h"
+
+// Append-only log of voxel edits, so saving a paint stroke writes a few bytes per
+// voxel instead of whole chunks. Records are absolute (voxel = value), so
+// replaying them in order over a chunk that already has some of them applied
+// still ends at the latest value.
+//
+// The log is split into numbered generations, one file each. rotate closes the
+// current generation and starts the next; once the closed edits are written into
+// the chunk files, dropThrough deletes them. Edits of every generation
+// still on disk are kept in memory by chunk so loads can replay them.
+class EditJournal {
+public:
+    struct Edit {
+        uint8_t x, y, z; // Local voxel position
+        Chunk::VoxelData voxel;
+    };
+    using EditsByChunk = std::map<Chunk::ChunkCoord, std::vector<Edit>>;
+
+    static constexpr uint32_t MAGIC = 0x4A455856; // "VXEJ"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t RECORD_BYTES = 3 * sizeof(int32_t) + 3 + 4 * sizeof(float) + sizeof(uint8_t) + sizeof(int32_t);
+    static_assert(Chunk::CHUNK_SIZE <= 256, "Local positions are stored in 8 bits");
+
+    // Reads every generation left in the directory; new edits go to a new one
+    explicit EditJournal(const std::string& directory) : directory(directory) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            uint64_t generation;
+            if (entry.is_regular_file() && parseGeneration(entry.path().filename().string(), generation)) {
+                readGeneration(generation);
+                currentGeneration = std::max(currentGeneration, generation + 1);
+            }
+        }
+    }
+
+    ~EditJournal() { flush(); }
+
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    void record(const Chunk::ChunkCoord& coord, int x, int y, int z, const Chunk::VoxelData& voxel) {
+        Edit edit{static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>(z), voxel};
+        std::lock_guard<std::mutex> lock(mutex);
+        generations[currentGeneration][coord].push_back(edit);
+        appendRecord(unflushed, coord, edit);
+        ++uncompacted;
+    }
+
+    // Append the edits recorded since the last flush to the current generation's file
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (unflushed.empty()) return true;
+        if (!file.is_open()) {
+            file.open(generationPath(currentGeneration), std::ios::binary | std::ios::app);
+            if (file.tellp() == 0) {
+                file.write(reinterpret_cast<const char*>(&MAGIC), sizeof(MAGIC));
+                file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+            }
+        }
+        file.write(reinterpret_cast<const char*>(unflushed.data()), unflushed.size());
+        file.flush();
+        if (!file.good()) {
+            file.clear();
+            LOG("Failed to append to edit journal: " + generationPath(currentGeneration));
+            return false;
+        }
+        unflushed.clear();
+        return true;
+    }
+
+    // Edits of every generation not yet compacted, oldest first
+    std::vector<Edit> editsFor(const Chunk::ChunkCoord& coord) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Edit> edits;
+        for (const auto& [generation, chunks] : generations) {
+            auto it = chunks.find(coord);
+            if (it != chunks.end()) edits.insert(edits.end(), it->second.begin(), it->second.end());
+        }
+        return edits;
+    }
+
+    size_t uncompactedEdits() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return uncompacted;
+    }
+
+    // Start a new generation and collect the edits of all earlier ones by chunk.
+    // Returns the newest closed generation, to pass to dropThrough once the edits
+    // are in the chunk files. Call flush first.
+    uint64_t rotate(EditsByChunk& closed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.close();
+        for (const auto& [generation, chunks] : generations) {
+            for (const auto& [coord, edits] : chunks) {
+                std::vector<Edit>& merged = closed[coord];
+                merged.insert(merged.end(), edits.begin(), edits.end());
+            }
+        }
+        return currentGeneration++;
+    }
+
+    // Forget generations up to and including the given one and delete their files
+    void dropThrough(uint64_t lastGeneration) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = generations.begin(); it != generations.end() && it->first <= lastGeneration;) {
+            for (const auto& [coord, edits] : it->second) uncompacted -= edits.size();
+            std::error_code error;
+            std::filesystem::remove(generationPath(it->first), error);
+            it = generations.erase(it);
+        }
+    }
+
+    // Drop every edit and delete all journal files
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.close();
+        unflushed.clear();
+        for (const auto& [generation, chunks] : generations) {
+            std::error_code error;
+            std::filesystem::remove(generationPath(generation), error);
+        }
+        generations.clear();
+        uncompacted = 0;
+        ++currentGeneration;
+    }
+
+    static void apply(Chunk& chunk, const std::vector<Edit>& edits) {
+        for (const Edit& edit : edits) {
+            chunk.setVoxel(edit.x, edit.y, edit.z, edit.voxel);
+        }
+    }
+
+private:
+    std::string directory;
+    std::map<uint64_t, EditsByChunk> generations; // Edits not yet in the chunk files
+    uint64_t currentGeneration = 0;
+    size_t uncompacted = 0;
+    std::vector<uint8_t> unflushed; // Encoded records waiting for flush
+    std::ofstream file;             // Current generation, opened on first flush
+    std::mutex mutex;
+
+    std::string generationPath(uint64_t generation) const {
+        return directory + "/edits_" + std::to_string(generation) + ".journal";
+    }
+
+    static bool parseGeneration(const std::string& name, uint64_t& generation) {
+        const std::string prefix = "edits_", suffix = ".journal";
+        if (name.size() <= prefix.size() + suffix.size() || name.rfind(prefix, 0) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) return false;
+        std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (digits.find_first_not_of("0123456789") != std::string::npos) return false;
+        generation = std::stoull(digits);
+        return true;
+    }
+
+    template <typename T>
+    static void put(std::vector<uint8_t>& out, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    static T get(const uint8_t*& data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return value;
+    }
+
+    static void appendRecord(std::vector<uint8_t>& out, const Chunk::ChunkCoord& coord, const Edit& edit) {
+        put<int32_t>(out, coord.x);
+        put<int32_t>(out, coord.y);
+        put<int32_t>(out, coord.z);
+        put(out, edit.x);
+        put(out, edit.y);
+        put(out, edit.z);
+        put(out, edit.voxel.color.r);
+        put(out, edit.voxel.color.g);
+        put(out, edit.voxel.color.b);
+        put(out, edit.voxel.color.a);
+        put(out, edit.voxel.type);
+        put<int32_t>(out, edit.voxel.textureId);
+    }
+
+    // Load a generation's records; a record cut short by a crash ends the file
+    void readGeneration(uint64_t generation) {
+        std::ifstream in(generationPath(generation), std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        uint32_t magic = 0, version = 0;
+        if (bytes.size() >= 8) {
+            std::memcpy(&magic, bytes.data(), 4);
+            std::memcpy(&version, bytes.data() + 4, 4);
+        }
+        if (magic != MAGIC || version != VERSION) {
+            LOG("Ignoring unreadable edit journal: " + generationPath(generation));
+            return;
+        }
+
+        EditsByChunk& chunks = generations[generation];
+        const uint8_t* data = bytes.data() + 8;
+        const uint8_t* end = bytes.data() + bytes.size();
+        while (size_t(end - data) >= RECORD_BYTES) {
+            Chunk::ChunkCoord coord;
+            coord.x = get<int32_t>(data);
+            coord.y = get<int32_t>(data);
+            coord.z = get<int32_t>(data);
+            Edit edit;
+            edit.x = get<uint8_t>(data);
+            edit.y = get<uint8_t>(data);
+            edit.z = get<uint8_t>(data);
+            edit.voxel.color.r = get<float>(data);
+            edit.voxel.color.g = get<float>(data);
+            edit.voxel.color.b = get<float>(data);
+            edit.voxel.color.a = get<float>(data);
+            edit.voxel.type = get<uint8_t>(data);
+            edit.voxel.textureId = get<int32_t>(data);
+            chunks[coord].push_back(edit);
+            ++uncompacted;
+        }
+    }
+};
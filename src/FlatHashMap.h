@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// Open-addressing hash table with the entries stored densely in a vector. The
+// probe array holds only an entry index and 32 bits of the hash per slot, so a
+// lookup touches one or two cache lines of slots and then the matching entry;
+// iteration walks the dense entries with no empty buckets in between. Slots are
+// probed linearly and removals shift later slots back, so there are no
+// tombstones and probe lengths stay short however many erases happen.
+//
+// Unlike the std unordered containers, inserting may move entries (references
+// to them do not survive it), and erasing moves the last entry into the erased
+// one's place. erase(iterator) returns an iterator to that same position, so
+// erase-while-iterating loops work as usual. Keys must not be changed through
+// iterators.
+//
+// Hash should mix well into the low bits, which pick the first slot.
+template <typename Key, typename Entry, typename KeyOf, typename Hash>
+class FlatHashTable {
+public:
+    using key_type = Key;
+    using value_type = Entry;
+    using iterator = typename std::vector<Entry>::iterator;
+    using const_iterator = typename std::vector<Entry>::const_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    iterator find(const Key& key) {
+        size_t slot = findSlot(key);
+        return slot == NOT_FOUND ? entries.end() : entries.begin() + slots[slot].index;
+    }
+
+    const_iterator find(const Key& key) const {
+        size_t slot = findSlot(key);
+        return slot == NOT_FOUND ? entries.end() : entries.begin() + slots[slot].index;
+    }
+
+    size_t count(const Key& key) const { return findSlot(key) == NOT_FOUND ? 0 : 1; }
+    bool contains(const Key& key) const { return findSlot(key) != NOT_FOUND; }
+
+    size_t erase(const Key& key) {
+        size_t slot = findSlot(key);
+        if (slot == NOT_FOUND) return 0;
+        eraseSlot(slot);
+        return 1;
+    }
+
+    iterator erase(const_iterator position) {
+        size_t index = static_cast<size_t>(position - entries.cbegin());
+        eraseSlot(findSlot(KeyOf()(entries[index])));
+        return entries.begin() + index;
+    }
+
+    void clear() {
+        entries.clear();
+        slots.assign(slots.size(), Slot{});
+    }
+
+    void reserve(size_t count) {
+        entries.reserve(count);
+        if (count * 2 > slots.size()) rehash(count * 2);
+    }
+
+protected:
+    std::vector<Entry> entries;
+
+    // Index of the entry with this key, inserting one built by make() if missing
+    template <typename Make>
+    std::pair<iterator, bool> findOrInsert(const Key& key, Make&& make) {
+        if ((entries.size() + 1) * 2 > slots.size()) rehash(slots.empty() ? MIN_SLOTS : slots.size() * 2);
+        uint64_t hash = hashOf(key);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            if (slots[slot].index == EMPTY) {
+                slots[slot] = Slot{static_cast<uint32_t>(entries.size()), fragment(hash)};
+                entries.push_back(make());
+                return {entries.end() - 1, true};
+            }
+            if (slots[slot].fragment == fragment(hash) && KeyOf()(entries[slots[slot].index]) == key) {
+                return {entries.begin() + slots[slot].index, false};
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        uint32_t index = EMPTY; // Into entries
+        uint32_t fragment = 0;  // High bits of the hash, checked before the key
+    };
+
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+    static constexpr size_t MIN_SLOTS = 16; // Power of two; kept at most half full
+
+    std::vector<Slot> slots;
+
+    static uint64_t hashOf(const Key& key) { return static_cast<uint64_t>(Hash()(key)); }
+    static uint32_t fragment(uint64_t hash) { return static_cast<uint32_t>(hash >> 32); }
+
+    size_t findSlot(const Key& key) const {
+        if (entries.empty()) return NOT_FOUND;
+        uint64_t hash = hashOf(key);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            if (slots[slot].index == EMPTY) return NOT_FOUND;
+            if (slots[slot].fragment == fragment(hash) && KeyOf()(entries[slots[slot].index]) == key) return slot;
+        }
+    }
+
+    void eraseSlot(size_t slot) {
+        size_t mask = slots.size() - 1;
+        uint32_t index = slots[slot].index;
+
+        // Shift back later slots of the probe run that may move into the hole
+        for (size_t next = (slot + 1) & mask; slots[next].index != EMPTY; next = (next + 1) & mask) {
+            size_t home = hashOf(KeyOf()(entries[slots[next].index])) & mask;
+            // Movable unless its home lies cyclically in (slot, next]
+            bool homeBetween = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+            if (!homeBetween) {
+                slots[slot] = slots[next];
+                slot = next;
+            }
+        }
+        slots[slot] = Slot{};
+
+        // Fill the entry's place with the last entry and repoint its slot
+        uint32_t last = static_cast<uint32_t>(entries.size() - 1);
+        if (index != last) {
+            size_t lastSlot = hashOf(KeyOf()(entries[last])) & mask;
+            while (slots[lastSlot].index != last) lastSlot = (lastSlot + 1) & mask;
+            slots[lastSlot].index = index;
+            entries[index] = std::move(entries[last]);
+        }
+        entries.pop_back();
+    }
+
+    void rehash(size_t minSlots) {
+        size_t count = MIN_SLOTS;
+        while (count < minSlots) count *= 2;
+        slots.assign(count, Slot{});
+        size_t mask = count - 1;
+        for (uint32_t i = 0; i < entries.size(); ++i) {
+            uint64_t hash = hashOf(KeyOf()(entries[i]));
+            size_t slot = hash & mask;
+            while (slots[slot].index != EMPTY) slot = (slot + 1) & mask;
+            slots[slot] = Slot{i, fragment(hash)};
+        }
+    }
+};
+
+namespace FlatHashDetail {
+    struct PairKey {
+        template <typename Pair>
+        const auto& operator()(const Pair& entry) const { return entry.first; }
+    };
+    struct SelfKey {
+        template <typename Key>
+        const Key& operator()(const Key& key) const { return key; }
+    };
+}
+
+// Entries are std::pair<Key, Value>, so range-for with [key, value] works as with
+// std::unordered_map
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class FlatHashMap : public FlatHashTable<Key, std::pair<Key, Value>, FlatHashDetail::PairKey, Hash> {
+public:
+    Value& operator[](const Key& key) {
+        return this->findOrInsert(key, [&] { return std::pair<Key, Value>(key, Value()); }).first->second;
+    }
+
+    template <typename... Args>
+    std::pair<typename FlatHashMap::iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        return this->findOrInsert(key, [&] {
+            return std::pair<Key, Value>(std::piecewise_construct, std::forward_as_tuple(key),
+                                         std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    // The key must be present
+    Value& at(const Key& key) { return this->find(key)->second; }
+    const Value& at(const Key& key) const { return this->find(key)->second; }
+};
+
+template <typename Key, typename Hash = std::hash<Key>>
+class FlatHashSet : public FlatHashTable<Key, Key, FlatHashDetail::SelfKey, Hash> {
+public:
+    std::pair<typename FlatHashSet::iterator, bool> insert(const Key& key) {
+        return this->findOrInsert(key, [&] { return key; });
+    }
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum planes pulled from a projection * view matrix, for culling boxes.
+// Planes follow the -w..w clip range on every axis; with a 0..w depth range the
+// near plane sits slightly behind the real one, which only makes culling conservative.
+class Frustum {
+public:
+    explicit Frustum(const glm::mat4& viewProj) {
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i) {
+            rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        }
+        planes[0] = rows[3] + rows[0]; // Left
+        planes[1] = rows[3] - rows[0]; // Right
+        planes[2] = rows[3] + rows[1]; // Bottom
+        planes[3] = rows[3] - rows[1]; // Top
+        planes[4] = rows[3] + rows[2]; // Near
+        planes[5] = rows[3] - rows[2]; // Far
+    }
+
+    // False only when the box lies entirely outside one of the planes
+    bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
+        for (const glm::vec4& plane : planes) {
+            // Corner furthest along the plane normal
+            glm::vec3 corner(
+                plane.x >= 0.0f ? max.x : min.x,
+                plane.y >= 0.0f ? max.y : min.y,
+                plane.z >= 0.0f ? max.z : min.z
+            );
+            if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    glm::vec4 planes[6];
+};
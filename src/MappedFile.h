@@ -0,0 +1,149 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file. Pages are read in by the OS as they
+// are touched, so parsing straight out of data() avoids a copy through a stream.
+// data() is null when the file is missing, empty or could not be mapped. The
+// mapping is shared, so writes to the file through other handles show through.
+class MappedFile {
+public:
+    enum class Access { Normal, Sequential, Random };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(mapped, other.mapped);
+            std::swap(length, other.length);
+#ifdef _WIN32
+            std::swap(fileHandle, other.fileHandle);
+            std::swap(mappingHandle, other.mappingHandle);
+#endif
+        }
+        return *this;
+    }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        // Other handles may keep writing, renaming or deleting the file
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mappingHandle) {
+            close();
+            return false;
+        }
+        void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            close();
+            return false;
+        }
+        mapped = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping keeps the file referenced
+        if (view == MAP_FAILED) return false;
+        mapped = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (mapped) UnmapViewOfFile(mapped);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (mapped) munmap(const_cast<uint8_t*>(mapped), length);
+#endif
+        mapped = nullptr;
+        length = 0;
+    }
+
+    // Tell the OS how the mapping will be read, to tune readahead
+    void adviseAccess(Access access) const {
+#ifndef _WIN32
+        if (!mapped) return;
+        int advice = (access == Access::Sequential) ? MADV_SEQUENTIAL :
+                     (access == Access::Random) ? MADV_RANDOM : MADV_NORMAL;
+        madvise(const_cast<uint8_t*>(mapped), length, advice);
+#else
+        (void)access; // No per-mapping equivalent; prefetch covers the ranges that matter
+#endif
+    }
+
+    // Start reading a range in ahead of touching it, as one request instead of a
+    // page fault per page
+    void prefetch(size_t offset, size_t size) const {
+        if (!mapped || offset >= length) return;
+        size = std::min(size, length - offset);
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t*>(mapped + offset), size};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        // The mapping starts on a page boundary, madvise needs the range to as well
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = offset & ~(pageSize - 1);
+        madvise(const_cast<uint8_t*>(mapped + start), size + (offset - start), MADV_WILLNEED);
+#endif
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    const uint8_t* data() const { return mapped; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* mapped = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+// Unbounded multi-producer, single-consumer queue. Producers link a node onto an
+// atomic list head with one CAS; the consumer detaches the whole list with one
+// exchange and reverses it into arrival order. Neither side ever takes a lock,
+// so a worker finishing a job can never stall the thread draining results.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    ~MpscQueue() {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    // Safe to call from any number of threads
+    void push(T value) {
+        Node* node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Append every queued item to out, oldest first. Consumer thread only.
+    template <typename Container>
+    size_t popAll(Container& out) {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        Node* oldest = nullptr;
+        while (node) {
+            Node* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (oldest) {
+            out.push_back(std::move(oldest->value));
+            Node* next = oldest->next;
+            delete oldest;
+            oldest = next;
+            ++count;
+        }
+        return count;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> head{nullptr};
+};
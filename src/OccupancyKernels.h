@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define ULTRAVOX_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#else
+    #define ULTRAVOX_X86 0
+#endif
+
+// GCC and Clang need the AVX2 kernels tagged so they compile without -mavx2;
+// MSVC accepts the intrinsics as-is.
+#if ULTRAVOX_X86 && (!defined(_MSC_VER) || defined(__clang__))
+    #define ULTRAVOX_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define ULTRAVOX_TARGET_AVX2
+#endif
+
+// Word-wide bit kernels over voxel occupancy masks. The AVX2 paths are picked
+// at runtime, so the same binary still runs on CPUs without AVX2.
+namespace OccupancyKernels {
+
+    inline bool cpuHasAVX2() {
+#if ULTRAVOX_X86
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false; // OS must save YMM state
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+#else
+        return false;
+#endif
+    }
+
+    inline bool useAVX2() {
+        static const bool supported = cpuHasAVX2();
+        return supported;
+    }
+
+#if ULTRAVOX_X86
+    ULTRAVOX_TARGET_AVX2 inline void andNotAVX2(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_andnot_si256(vb, va));
+        }
+        for (; i < count; ++i) out[i] = a[i] & ~b[i];
+    }
+
+    ULTRAVOX_TARGET_AVX2 inline void orIntoAVX2(uint64_t* out, const uint64_t* a, size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m256i vo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + i));
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(vo, va));
+        }
+        for (; i < count; ++i) out[i] |= a[i];
+    }
+#endif
+
+    // out[i] = a[i] & ~b[i]  (out may alias a)
+    inline void andNot(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t count) {
+#if ULTRAVOX_X86
+        if (useAVX2()) {
+            andNotAVX2(out, a, b, count);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i) out[i] = a[i] & ~b[i];
+    }
+
+    // out[i] |= a[i]
+    inline void orInto(uint64_t* out, const uint64_t* a, size_t count) {
+#if ULTRAVOX_X86
+        if (useAVX2()) {
+            orIntoAVX2(out, a, count);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i) out[i] |= a[i];
+    }
+}
@@ -0,0 +1,516 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+
+#include "Logger.h"
+#include "MappedFile.h"
+
+// Container file holding the data of REGION_SIZE^3 chunks. The file starts with a
+// header table giving each chunk slot its first sector and byte length; chunk data
+// lives in whole SECTOR_SIZE sectors after it. One open file and a seek per access
+// replaces creating and opening a file per chunk.
+//
+// Writes never overwrite a chunk's current sectors: the new data goes to the
+// first free run (or the end of the file), then the table entry is switched to it
+// and the old sectors become free. A crash mid-write leaves the previous version
+// intact, and a chunk saved repeatedly alternates between two runs instead of
+// growing the file. compact() rewrites the file with every chunk packed in slot
+// order.
+//
+// Reads come straight out of a memory mapping of the file, remapped when writes
+// have grown the file past it. The mapping is shared, so writes show through it:
+// a View keeps the mapping it points into alive, and the sectors it points at
+// are not reused for other data until it and every View handed out with it are
+// released. The bytes of a View therefore stay those of the entry it was read
+// from.
+class RegionFile {
+public:
+    struct View {
+        std::shared_ptr<const MappedFile> mapping;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::shared_ptr<const void> readers; // Holds back reuse of the sectors it points at
+    };
+
+    static constexpr int REGION_SIZE = 8;
+    static constexpr int CHUNKS_PER_REGION = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+    static constexpr uint32_t SECTOR_SIZE = 4096;
+    static constexpr uint32_t MAGIC = 0x52584F56; // "VOXR"
+    static constexpr uint32_t VERSION = 1;
+
+    // Slot of a chunk within its region, from the chunk coordinate mod REGION_SIZE
+    static int slotIndex(int x, int y, int z) {
+        return wrap(x) + wrap(y) * REGION_SIZE + wrap(z) * REGION_SIZE * REGION_SIZE;
+    }
+
+    // Region containing a chunk coordinate (floor division)
+    static int regionCoord(int chunkCoord) {
+        return (chunkCoord >= 0) ? chunkCoord / REGION_SIZE : (chunkCoord - (REGION_SIZE - 1)) / REGION_SIZE;
+    }
+
+    // Open an existing region file, or create an empty one if create is set.
+    // isOpen() is false when the file is missing (and not created) or invalid.
+    RegionFile(const std::string& path, bool create) : path(path) {
+        if (!std::filesystem::exists(path)) {
+            if (!create) return;
+            std::ofstream init(path, std::ios::binary);
+            Header empty{};
+            empty.magic = MAGIC;
+            empty.version = VERSION;
+            init.write(reinterpret_cast<const char*>(&empty), sizeof(Header));
+            if (!init.good()) {
+                LOG("Failed to create region file: " + path);
+                return;
+            }
+        }
+
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) return;
+        file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+        if (!file.good() || header.magic != MAGIC || header.version != VERSION) {
+            LOG("Invalid region file: " + path);
+            file.close();
+            return;
+        }
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(path, error);
+        if (error) {
+            LOG("Invalid region file: " + path);
+            file.close();
+            return;
+        }
+        validateEntries(fileSize);
+    }
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    bool isOpen() const { return file.is_open(); }
+    const std::string& getPath() const { return path; }
+
+    bool contains(int slot) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return header.entries[slot].byteCount != 0;
+    }
+
+    // Point out at a chunk's bytes in the mapping; false when the slot is empty
+    // or the file cannot be mapped
+    bool read(int slot, View& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Entry& entry = header.entries[slot];
+        if (!file.is_open() || entry.byteCount == 0) return false;
+        size_t offset = static_cast<size_t>(entry.firstSector) * SECTOR_SIZE;
+        if (!mapping || mapping->size() < offset + entry.byteCount) {
+            auto remapped = std::make_shared<MappedFile>(path);
+            if (remapped->size() < offset + entry.byteCount) return false;
+            // Chunks are fetched in whatever order the camera needs them
+            remapped->adviseAccess(MappedFile::Access::Random);
+            mapping = std::move(remapped);
+        }
+        mapping->prefetch(offset, entry.byteCount);
+        if (!readers) readers = std::make_shared<char>();
+        out.readers = readers;
+        out.mapping = mapping;
+        out.data = mapping->data() + offset;
+        out.size = entry.byteCount;
+        return true;
+    }
+
+    bool write(int slot, const char* data, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file.is_open()) return false;
+        if (size == 0 || size > UINT32_MAX) return false;
+
+        Entry& entry = header.entries[slot];
+        uint32_t needed = sectorsFor(static_cast<uint32_t>(size));
+        releaseSectors();
+        uint32_t first = allocate(needed);
+
+        file.seekp(static_cast<std::streamoff>(first) * SECTOR_SIZE);
+        file.write(data, size);
+        // Pad the last sector so the file always ends on a sector boundary
+        uint32_t padding = needed * SECTOR_SIZE - static_cast<uint32_t>(size);
+        if (padding) {
+            static const std::array<char, SECTOR_SIZE> zeros{};
+            file.write(zeros.data(), padding);
+        }
+        file.flush();
+        if (!file.good()) {
+            file.clear();
+            LOG("Failed to write chunk to region file: " + path);
+            return false;
+        }
+
+        // Commit: the entry is switched only once the data is in the file
+        markSectors(first, needed, true);
+        if (entry.byteCount != 0) freeSectors(entry.firstSector, sectorsFor(entry.byteCount));
+        entry.firstSector = first;
+        entry.byteCount = static_cast<uint32_t>(size);
+        writeEntry(slot);
+        file.flush();
+        if (!file.good()) {
+            file.clear();
+            LOG("Failed to write chunk to region file: " + path);
+            return false;
+        }
+        return true;
+    }
+
+    // Free a slot; its sectors become reusable
+    void erase(int slot) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = header.entries[slot];
+        if (!file.is_open() || entry.byteCount == 0) return;
+        freeSectors(entry.firstSector, sectorsFor(entry.byteCount));
+        entry = Entry{};
+        writeEntry(slot);
+        file.flush();
+    }
+
+    // Sectors between header and end of file that hold no chunk data
+    uint32_t wastedSectors() {
+        std::lock_guard<std::mutex> lock(mutex);
+        releaseSectors();
+        uint32_t wasted = 0;
+        for (uint32_t sector = HEADER_SECTORS; sector < usedSectors.size(); ++sector) {
+            if (!usedSectors[sector]) ++wasted;
+        }
+        return wasted;
+    }
+
+    // Whether Views may still point into sectors this file is holding back;
+    // reopened, it would know nothing of them and hand them out again
+    bool hasReaders() {
+        std::lock_guard<std::mutex> lock(mutex);
+        releaseSectors();
+        return !pendingFrees.empty() || (readers && readers.use_count() > 1);
+    }
+
+    uint32_t totalSectors() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<uint32_t>(usedSectors.size());
+    }
+
+    // Rewrite the file with all chunks back to back in slot order. Goes through a
+    // temporary file that replaces the region only once fully written.
+    bool compact() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file.is_open()) return false;
+
+        std::string tempPath = path + ".tmp";
+        Header packed{};
+        packed.magic = MAGIC;
+        packed.version = VERSION;
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&packed), sizeof(Header));
+            std::vector<char> buffer;
+            uint32_t nextSector = HEADER_SECTORS;
+            for (int slot = 0; slot < CHUNKS_PER_REGION; ++slot) {
+                const Entry& entry = header.entries[slot];
+                if (entry.byteCount == 0) continue;
+                uint32_t sectors = sectorsFor(entry.byteCount);
+                buffer.assign(static_cast<size_t>(sectors) * SECTOR_SIZE, 0);
+                file.seekg(static_cast<std::streamoff>(entry.firstSector) * SECTOR_SIZE);
+                file.read(buffer.data(), entry.byteCount);
+                if (!file.good()) {
+                    file.clear();
+                    LOG("Region compaction failed reading: " + path);
+                    return false;
+                }
+                out.write(buffer.data(), buffer.size());
+                packed.entries[slot] = Entry{nextSector, entry.byteCount};
+                nextSector += sectors;
+            }
+            out.seekp(0);
+            out.write(reinterpret_cast<const char*>(&packed), sizeof(Header));
+            if (!out.good()) {
+                LOG("Region compaction failed writing: " + tempPath);
+                return false;
+            }
+        }
+
+        file.close();
+        mapping.reset(); // Views still out keep the old file's pages
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (error) {
+            LOG("Region compaction failed replacing: " + path);
+            return file.is_open();
+        }
+        header = packed;
+        pendingFrees.clear(); // Views still out point into the old file
+        readers.reset();
+        rebuildSectorMap();
+        return file.is_open();
+    }
+
+private:
+    struct Entry {
+        uint32_t firstSector = 0;
+        uint32_t byteCount = 0; // 0 = slot empty
+    };
+
+    // Padded to whole sectors so chunk data starts sector aligned
+    static constexpr uint32_t HEADER_SECTORS = (8 + CHUNKS_PER_REGION * sizeof(Entry) + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    struct Header {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        Entry entries[CHUNKS_PER_REGION];
+        char padding[HEADER_SECTORS * SECTOR_SIZE - 8 - CHUNKS_PER_REGION * sizeof(Entry)] = {};
+    };
+    static_assert(sizeof(Header) == HEADER_SECTORS * SECTOR_SIZE, "Region header must fill whole sectors");
+
+    std::string path;
+    std::fstream file;
+    Header header{};
+    std::vector<bool> usedSectors; // One flag per sector in the file, header included
+    std::shared_ptr<const MappedFile> mapping;
+    std::shared_ptr<const void> readers; // Shared by the Views handed out since the last free
+
+    // Sectors that stay allocated until the Views that may point into them are gone
+    struct PendingFree {
+        uint32_t first;
+        uint32_t count;
+        std::weak_ptr<const void> readers;
+    };
+    std::vector<PendingFree> pendingFrees;
+    std::mutex mutex;
+
+    static int wrap(int c) { return ((c % REGION_SIZE) + REGION_SIZE) % REGION_SIZE; }
+    static uint32_t sectorsFor(uint32_t bytes) { return (bytes + SECTOR_SIZE - 1) / SECTOR_SIZE; }
+
+    void rebuildSectorMap() {
+        usedSectors.assign(HEADER_SECTORS, true);
+        for (const Entry& entry : header.entries) {
+            if (entry.byteCount != 0) markSectors(entry.firstSector, sectorsFor(entry.byteCount), true);
+        }
+    }
+
+    // Build the sector map from a header read from disk, clearing entries that
+    // start inside the header, run past the end of the file or overlap an earlier
+    // entry. Trusting them would size the map from garbage, or free the header's
+    // sectors on the entry's next rewrite.
+    void validateEntries(uint64_t fileSize) {
+        usedSectors.assign(HEADER_SECTORS, true);
+        for (int slot = 0; slot < CHUNKS_PER_REGION; ++slot) {
+            Entry& entry = header.entries[slot];
+            if (entry.byteCount == 0) continue;
+            uint32_t count = sectorsFor(entry.byteCount);
+            bool valid = entry.firstSector >= HEADER_SECTORS &&
+                         uint64_t(entry.firstSector) * SECTOR_SIZE + entry.byteCount <= fileSize;
+            for (uint32_t sector = entry.firstSector; valid && sector < entry.firstSector + count && sector < usedSectors.size(); ++sector) {
+                valid = !usedSectors[sector];
+            }
+            if (!valid) {
+                LOG("Invalid region entry " + std::to_string(slot) + ", clearing it: " + path);
+                entry = Entry{};
+                writeEntry(slot);
+                continue;
+            }
+            markSectors(entry.firstSector, count, true);
+        }
+        file.flush();
+        if (!file.good()) file.clear();
+    }
+
+    void markSectors(uint32_t first, uint32_t count, bool used) {
+        if (used && usedSectors.size() < size_t(first) + count) usedSectors.resize(size_t(first) + count, false);
+        for (uint32_t sector = first; sector < first + count && sector < usedSectors.size(); ++sector) {
+            usedSectors[sector] = used;
+        }
+        // Trailing free sectors are simply the end of the file
+        while (usedSectors.size() > HEADER_SECTORS && !usedSectors.back()) usedSectors.pop_back();
+    }
+
+    // A chunk's old sectors. The mapping is shared with the file, so while a View
+    // handed out before now may still be decoding them they are kept allocated;
+    // later Views get a new token so they do not hold these back.
+    void freeSectors(uint32_t first, uint32_t count) {
+        if (readers && readers.use_count() > 1) {
+            pendingFrees.push_back(PendingFree{first, count, readers});
+            readers.reset();
+        } else {
+            markSectors(first, count, false);
+        }
+    }
+
+    // Free the pending sectors no View can reach anymore. No View is handed out
+    // without the lock, so an expired token stays expired.
+    void releaseSectors() {
+        for (size_t i = 0; i < pendingFrees.size();) {
+            if (pendingFrees[i].readers.expired()) {
+                markSectors(pendingFrees[i].first, pendingFrees[i].count, false);
+                pendingFrees[i] = pendingFrees.back();
+                pendingFrees.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // First run of free sectors long enough, else the end of the file
+    uint32_t allocate(uint32_t count) {
+        uint32_t run = 0;
+        for (uint32_t sector = HEADER_SECTORS; sector < usedSectors.size(); ++sector) {
+            run = usedSectors[sector] ? 0 : run + 1;
+            if (run == count) return sector + 1 - count;
+        }
+        return static_cast<uint32_t>(usedSectors.size()) - run;
+    }
+
+    void writeEntry(int slot) {
+        file.seekp(offsetof(Header, entries) + slot * sizeof(Entry));
+        file.write(reinterpret_cast<const char*>(&header.entries[slot]), sizeof(Entry));
+    }
+};
+
+// The region files of one world directory, opened on demand and shared by the
+// main thread and loader threads. A bounded number stay open; a region that is
+// closed with much of its space wasted is compacted first, which is also the
+// defragmentation pass run for every open region on shutdown.
+class RegionStore {
+public:
+    static constexpr size_t MAX_OPEN_REGIONS = 32;
+
+    RegionStore(const std::string& directory, const std::string& extension)
+        : directory(directory), extension(extension) {}
+
+    ~RegionStore() {
+        for (auto& [key, open] : regions) closeRegion(*open.region);
+    }
+
+    bool read(int chunkX, int chunkY, int chunkZ, RegionFile::View& out) {
+        std::shared_ptr<RegionFile> region = getRegion(chunkX, chunkY, chunkZ, false);
+        return region && region->read(RegionFile::slotIndex(chunkX, chunkY, chunkZ), out);
+    }
+
+    bool write(int chunkX, int chunkY, int chunkZ, const char* data, size_t size) {
+        std::shared_ptr<RegionFile> region = getRegion(chunkX, chunkY, chunkZ, true);
+        return region && region->write(RegionFile::slotIndex(chunkX, chunkY, chunkZ), data, size);
+    }
+
+    void erase(int chunkX, int chunkY, int chunkZ) {
+        std::shared_ptr<RegionFile> region = getRegion(chunkX, chunkY, chunkZ, false);
+        if (region) region->erase(RegionFile::slotIndex(chunkX, chunkY, chunkZ));
+    }
+
+    // Close and delete every region file of this store
+    void removeAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        regions.clear();
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            std::error_code error; // A loader may still hold the file open; it will be overwritten later
+            if (isRegionFile(entry)) std::filesystem::remove(entry.path(), error);
+        }
+    }
+
+    // Call fn(chunkX, chunkY, chunkZ, view) for every chunk in the directory's
+    // region files
+    template <typename Fn>
+    void forEachChunk(Fn&& fn) {
+        std::vector<RegionKey> keys;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            RegionKey key;
+            int length = 0;
+            std::string name = entry.path().stem().string();
+            if (isRegionFile(entry) && std::sscanf(name.c_str(), "region_%d_%d_%d%n", &key.x, &key.y, &key.z, &length) == 3 &&
+                length == static_cast<int>(name.size())) {
+                keys.push_back(key);
+            }
+        }
+
+        constexpr int SIZE = RegionFile::REGION_SIZE;
+        for (const RegionKey& key : keys) {
+            std::shared_ptr<RegionFile> region = getRegion(key.x * SIZE, key.y * SIZE, key.z * SIZE, false);
+            if (!region) continue;
+            for (int slot = 0; slot < RegionFile::CHUNKS_PER_REGION; ++slot) {
+                RegionFile::View view;
+                if (!region->read(slot, view)) continue;
+                fn(key.x * SIZE + slot % SIZE, key.y * SIZE + slot / SIZE % SIZE, key.z * SIZE + slot / (SIZE * SIZE), view);
+            }
+        }
+    }
+
+    std::string regionPath(int regionX, int regionY, int regionZ) const {
+        return directory + "/region_" +
+               std::to_string(regionX) + "_" +
+               std::to_string(regionY) + "_" +
+               std::to_string(regionZ) + extension;
+    }
+
+private:
+    struct RegionKey {
+        int x, y, z;
+        bool operator==(const RegionKey& other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+    struct RegionKeyHash {
+        size_t operator()(const RegionKey& key) const {
+            return (size_t(uint32_t(key.x)) * 73856093u) ^ (size_t(uint32_t(key.y)) * 19349663u) ^ (size_t(uint32_t(key.z)) * 83492791u);
+        }
+    };
+    struct OpenRegion {
+        std::shared_ptr<RegionFile> region;
+        uint64_t lastUse = 0;
+    };
+
+    std::string directory;
+    std::string extension;
+    std::unordered_map<RegionKey, OpenRegion, RegionKeyHash> regions;
+    uint64_t useCounter = 0;
+    std::mutex mutex;
+
+    bool isRegionFile(const std::filesystem::directory_entry& entry) const {
+        return entry.is_regular_file() && entry.path().extension() == extension &&
+               entry.path().filename().string().rfind("region_", 0) == 0;
+    }
+
+    std::shared_ptr<RegionFile> getRegion(int chunkX, int chunkY, int chunkZ, bool create) {
+        RegionKey key{RegionFile::regionCoord(chunkX), RegionFile::regionCoord(chunkY), RegionFile::regionCoord(chunkZ)};
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = regions.find(key);
+        if (it != regions.end()) {
+            it->second.lastUse = ++useCounter;
+            return it->second.region;
+        }
+
+        auto region = std::make_shared<RegionFile>(regionPath(key.x, key.y, key.z), create);
+        if (!region->isOpen()) return nullptr;
+
+        if (regions.size() >= MAX_OPEN_REGIONS) {
+            // Regions another thread is still using stay open, so a path never has
+            // two RegionFiles with diverging headers, and so do regions with Views
+            // out, whose freed sectors must not be reused meanwhile
+            auto oldest = regions.end();
+            for (auto candidate = regions.begin(); candidate != regions.end(); ++candidate) {
+                if (candidate->second.region.use_count() > 1 || candidate->second.region->hasReaders()) continue;
+                if (oldest == regions.end() || candidate->second.lastUse < oldest->second.lastUse) oldest = candidate;
+            }
+            if (oldest != regions.end()) {
+                closeRegion(*oldest->second.region);
+                regions.erase(oldest);
+            }
+        }
+        regions[key] = OpenRegion{region, ++useCounter};
+        return region;
+    }
+
+    // Compact on close when more than a quarter of the file is holes
+    static void closeRegion(RegionFile& region) {
+        uint32_t wasted = region.wastedSectors();
+        if (wasted > 0 && wasted * 4 > region.totalSectors()) region.compact();
+    }
+};
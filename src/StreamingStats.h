@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <ostream>
+#include <cmath>
+#include <cstddef>
+
+// Where chunk streaming spends its time. Every chunk that loads, meshes or
+// uploads adds one sample per stage it went through, and queue depths are
+// sampled once per frame. Each metric keeps only its most recent samples, so
+// percentiles describe the current load rather than the whole session.
+// Recorded from the loader and mesh threads as well as the main thread.
+class StreamingStats {
+public:
+    enum class Metric {
+        // Milliseconds per chunk
+        QueueWait,    // Load request queued until a loader picks it up
+        Read,         // Fetching stored bytes and checking them against the manifest
+        Decode,       // Stored or cached bytes to voxels
+        Generate,     // Terrain generation of chunks not on disk
+        Surface,      // Collecting physics surface voxels
+        MeshCache,    // Checking and loading the mesh cache
+        Install,      // Octree inserts and neighbor links on the main thread
+        LoadTotal,    // Request to installed
+        Mesh,         // Meshing dirty sections on a worker
+        Upload,       // Uploading a frame's rebuilt sections to the GPU in one batch
+        Frame,        // Whole frame, recorded by the renderer
+        // Queue depths, sampled per frame
+        LoadRequests, // Requests no loader has picked up
+        LoadsPending, // Requested and not installed
+        InstallQueue, // Read and waiting to be installed
+        MeshJobs,     // Mesh jobs not integrated
+        PendingSaves, // Chunk and mesh cache writes not on disk
+        Count
+    };
+
+    static constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+    static constexpr size_t WINDOW = 1024; // Samples kept per metric
+
+    struct Summary {
+        size_t samples = 0; // In the window
+        size_t total = 0;   // Since the last reset
+        float mean = 0.0f;
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        float max = 0.0f;
+    };
+
+    // Milliseconds since construction or the previous lap
+    class Timer {
+    public:
+        float lap() {
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<float, std::milli> elapsed = now - start;
+            start = now;
+            return elapsed.count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
+    static const char* name(Metric metric) {
+        static constexpr const char* NAMES[METRIC_COUNT] = {
+            "queue_wait", "read", "decode", "generate", "surface", "mesh_cache", "install",
+            "load_total", "mesh", "upload", "frame",
+            "load_requests", "loads_pending", "install_queue", "mesh_jobs", "pending_saves",
+        };
+        return NAMES[static_cast<size_t>(metric)];
+    }
+
+    static bool isTiming(Metric metric) { return metric < Metric::LoadRequests; }
+
+    void record(Metric metric, float value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Window& window = windows[static_cast<size_t>(metric)];
+        if (window.samples.size() < WINDOW) {
+            window.samples.push_back(value);
+        } else {
+            window.samples[window.next] = value;
+        }
+        window.next = (window.next + 1) % WINDOW;
+        ++window.total;
+    }
+
+    Summary summary(Metric metric) {
+        std::vector<float> sorted;
+        Summary result;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const Window& window = windows[static_cast<size_t>(metric)];
+            sorted = window.samples;
+            result.total = window.total;
+        }
+        result.samples = sorted.size();
+        if (sorted.empty()) return result;
+
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (float value : sorted) sum += value;
+        result.mean = static_cast<float>(sum / sorted.size());
+        result.p50 = percentile(sorted, 0.50f);
+        result.p95 = percentile(sorted, 0.95f);
+        result.p99 = percentile(sorted, 0.99f);
+        result.max = sorted.back();
+        return result;
+    }
+
+    // One row per metric over the current windows
+    void writeCsv(std::ostream& out) {
+        out << "metric,unit,samples,total,mean,p50,p95,p99,max\n";
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            Metric metric = static_cast<Metric>(m);
+            Summary s = summary(metric);
+            out << name(metric) << ',' << (isTiming(metric) ? "ms" : "count") << ',' << s.samples << ',' << s.total << ','
+                << s.mean << ',' << s.p50 << ',' << s.p95 << ',' << s.p99 << ',' << s.max << '\n';
+        }
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        windows = {};
+    }
+
+private:
+    struct Window {
+        std::vector<float> samples; // Ring buffer once full
+        size_t next = 0;
+        size_t total = 0;
+    };
+
+    std::array<Window, METRIC_COUNT> windows;
+    std::mutex mutex;
+
+    // Nearest rank
+    static float percentile(const std::vector<float>& sorted, float fraction) {
+        size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+};
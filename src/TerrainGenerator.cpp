@@ -1,5 +1,7 @@
 #include "TerrainGenerator.h"
 
+#include <algorithm>
+
 #define FNL_IMPL
 #include "FastNoiseLite.h"
 
@@ -29,9 +31,11 @@ void TerrainGenerator::setOctaves(int newOctaves) {
     noise.octaves = octaves;
 }
 
-void TerrainGenerator::generateChunk(Chunk* chunk) {
+void TerrainGenerator::generateChunk(Chunk* chunk) const {
     const Chunk::ChunkCoord& coord = chunk->getCoordinate();
     glm::vec3 chunkWorldPos = chunk->getWorldPosition();
+    // Heights are in world voxels, so only chunks the surface passes through get terrain
+    int chunkBaseY = coord.y * Chunk::CHUNK_SIZE;
 
     for (int x = 0; x < Chunk::CHUNK_SIZE; ++x) {
         for (int z = 0; z < Chunk::CHUNK_SIZE; ++z) {
@@ -41,12 +45,15 @@ void TerrainGenerator::generateChunk(Chunk* chunk) {
             float noiseVal = fnlGetNoise2D(&noise, worldX, worldZ);
             int height = static_cast<int>((noiseVal + 1.0f) * 0.5f * 8);
 
-            for (int y = 0; y < height; ++y) {
+            int yBegin = std::max(0, -chunkBaseY);
+            int yEnd = std::min(Chunk::CHUNK_SIZE, height - chunkBaseY);
+            for (int y = yBegin; y < yEnd; ++y) {
+                int worldY = chunkBaseY + y;
                 int textureToUse = 0; // Default texture ID
-                if (y < height - 5) {
+                if (worldY < height - 5) {
                     // Stone
                     textureToUse = stoneTextureId;
-                } else if (y < height - 1) {
+                } else if (worldY < height - 1) {
                     // Dirt
                     textureToUse = dirtTextureId;
                 } else {
@@ -54,10 +61,10 @@ void TerrainGenerator::generateChunk(Chunk* chunk) {
                     textureToUse = grassTextureId;
                 }
                 chunk->setVoxel(x, y, z, Chunk::VoxelData(glm::vec4(1.0f), 1, textureToUse));
-
-                glm::vec3 voxelWorldPos = chunkWorldPos + glm::vec3(x, y, z) * Chunk::VOXEL_SIZE;
-                Chunk::PhysicsVoxelData physicsData(voxelWorldPos, Chunk::VOXEL_SIZE, 1);
             }
         }
     }
+
+    // Solid stone and open sky bricks collapse back to a single value
+    chunk->compactBricks();
 }
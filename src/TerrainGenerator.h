@@ -12,7 +12,16 @@ public:
     void setFrequency(float frequency);
     void setOctaves(int octaves);
 
-    void generateChunk(Chunk* chunk);
+    int getSeed() const { return seed; }
+    float getFrequency() const { return frequency; }
+    int getOctaves() const { return octaves; }
+    int getGrassTextureId() const { return grassTextureId; }
+    int getDirtTextureId() const { return dirtTextureId; }
+    int getStoneTextureId() const { return stoneTextureId; }
+
+    // Deterministic for a given seed, frequency and octaves; safe to call from
+    // several threads at once
+    void generateChunk(Chunk* chunk) const;
 
 private:
     fnl_state noise;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <cassert>
+
+// Packed vertex for chunk meshes, 8 bytes instead of Vertex's 64.
+// Positions are chunk-relative voxel corners (0..CHUNK_SIZE); the chunk's world
+// offset comes from the model matrix in MeshPushConstants. UVs and the normal
+// vector are rebuilt in voxel.vert from the face index.
+//
+// positionNormal: x (8) | y (8) | z (8) | face (3) | textureId (5)
+// material:       r (8) | g (8) | b (8) | a (8)
+struct VoxelVertex {
+    uint32_t positionNormal;
+    uint32_t material;
+
+    // Texture ids are 5 bits; shader.frag samples at most MAX_TEXTURES (12) of them
+    static constexpr int MAX_TEXTURE_ID = 31;
+
+    // faceIndex follows Chunk::addFace (0 top, 1 bottom, 2 right, 3 left, 4 front, 5 back)
+    static VoxelVertex pack(const glm::ivec3& position, int faceIndex, int textureId, const glm::vec4& color) {
+        assert(textureId >= 0 && textureId <= MAX_TEXTURE_ID && "Texture id does not fit VoxelVertex");
+        VoxelVertex v;
+        v.positionNormal = (static_cast<uint32_t>(position.x) & 0xFF)
+                         | (static_cast<uint32_t>(position.y) & 0xFF) << 8
+                         | (static_cast<uint32_t>(position.z) & 0xFF) << 16
+                         | (static_cast<uint32_t>(faceIndex) & 0x7) << 24
+                         | (static_cast<uint32_t>(glm::clamp(textureId, 0, MAX_TEXTURE_ID))) << 27;
+        v.material = toByte(color.r)
+                   | toByte(color.g) << 8
+                   | toByte(color.b) << 16
+                   | toByte(color.a) << 24;
+        return v;
+    }
+
+    glm::ivec3 position() const {
+        return glm::ivec3(positionNormal & 0xFF, (positionNormal >> 8) & 0xFF, (positionNormal >> 16) & 0xFF);
+    }
+    int faceIndex() const { return (positionNormal >> 24) & 0x7; }
+    int textureId() const { return (positionNormal >> 27) & 0x1F; }
+
+    static VkVertexInputBindingDescription getBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = sizeof(VoxelVertex);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescription;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+
+        // Position, face and texture ID
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[0].offset = offsetof(VoxelVertex, positionNormal);
+
+        // Color
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[1].offset = offsetof(VoxelVertex, material);
+
+        return attributeDescriptions;
+    }
+
+private:
+    static uint32_t toByte(float channel) {
+        return static_cast<uint32_t>(glm::clamp(channel, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+};
+
+static_assert(sizeof(VoxelVertex) == 8, "VoxelVertex must stay 8 bytes");
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <bitset>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#include "Chunk.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "RegionFile.h"
+
+// Index of every chunk persisted in a world directory: the size and checksum of
+// its region entry and a few summary flags, kept per region with one presence
+// bit per slot. Read once when the world opens, so knowing whether a chunk is on
+// disk is a bit test instead of probing region and chunk files for it.
+//
+// The file is only trusted while it matches the regions: the first write after
+// a save deletes it, and save() writes it again, through a temporary file that
+// is renamed over it, once no write is in flight. A world opened without one
+// (from before manifests, or after a crash) has it rebuilt from its regions.
+class WorldManifest {
+public:
+    static constexpr uint8_t EMPTY = 1 << 0;       // No voxels; loads as a new chunk
+    static constexpr uint8_t MESH_CACHED = 1 << 1; // Has a mesh cache entry
+    static constexpr uint8_t LEGACY_FILE = 1 << 2; // In a chunk file from before regions
+
+    struct Entry {
+        uint32_t size = 0;     // Bytes of the region entry; 0 if none
+        uint32_t checksum = 0; // CRC-32 of the region entry
+        uint8_t flags = 0;
+
+        bool hasChunk() const { return size != 0 || (flags & LEGACY_FILE); }
+    };
+
+    static constexpr uint32_t MAGIC = 0x4D575856; // "VXWM"
+    static constexpr uint32_t VERSION = 1;
+
+    explicit WorldManifest(const std::string& directory) : path(directory + "/world.manifest") {
+        loaded = load();
+        onDisk = loaded;
+        dirty = !loaded; // Written once rebuilt
+    }
+
+    ~WorldManifest() { save(); }
+
+    WorldManifest(const WorldManifest&) = delete;
+    WorldManifest& operator=(const WorldManifest&) = delete;
+
+    // False if there was no valid manifest to read and it needs rebuilding
+    bool wasLoaded() const { return loaded; }
+
+    // The chunk's entry; false if nothing is stored for it
+    bool find(const Chunk::ChunkCoord& coord, Entry& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = regions.find(regionKey(coord));
+        if (it == regions.end()) return false;
+        int slot = RegionFile::slotIndex(coord.x, coord.y, coord.z);
+        if (!it->second.present[slot]) return false;
+        out = it->second.entries[slot];
+        return true;
+    }
+
+    size_t chunkCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = 0;
+        for (const auto& [key, region] : regions) {
+            for (int slot = 0; slot < RegionFile::CHUNKS_PER_REGION; ++slot) {
+                if (region.present[slot] && region.entries[slot].hasChunk()) ++count;
+            }
+        }
+        return count;
+    }
+
+    // Bracket every region write, so the saved manifest is removed before the
+    // regions change and is not written again while they are changing
+    void beginWrite() {
+        std::unique_lock<std::mutex> lock(mutex);
+        saved.wait(lock, [this] { return !saving; });
+        ++writesInFlight;
+        dirty = true;
+        if (onDisk) {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+            onDisk = false;
+        }
+    }
+
+    void endWrite() {
+        std::lock_guard<std::mutex> lock(mutex);
+        --writesInFlight;
+    }
+
+    // A chunk's region entry was written; it supersedes any chunk file
+    void setChunk(const Chunk::ChunkCoord& coord, const uint8_t* data, size_t size, bool empty) {
+        uint32_t crc = checksum(data, size);
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = insert(coord);
+        entry.size = static_cast<uint32_t>(size);
+        entry.checksum = crc;
+        entry.flags = (entry.flags & MESH_CACHED) | (empty ? EMPTY : 0);
+        dirty = true;
+    }
+
+    void setMeshCached(const Chunk::ChunkCoord& coord) {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(coord).flags |= MESH_CACHED;
+        dirty = true;
+    }
+
+    void setLegacyFile(const Chunk::ChunkCoord& coord) {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(coord).flags |= LEGACY_FILE;
+        dirty = true;
+    }
+
+    // Forget every chunk and save the empty manifest, e.g. once the world's files are deleted
+    void clear() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            saved.wait(lock, [this] { return !saving; });
+            regions.clear();
+            dirty = true;
+        }
+        save();
+    }
+
+    // Write the manifest if it changed and no region write is in flight; false if
+    // writing it failed
+    bool save() {
+        std::vector<uint8_t> bytes;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!dirty || writesInFlight > 0 || saving) return true;
+            encode(bytes);
+            saving = true; // Writes wait so the file cannot go stale before it is renamed in
+        }
+
+        std::string tempPath = path + ".tmp";
+        bool ok;
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            ok = out.good();
+        }
+        std::error_code error;
+        if (ok) std::filesystem::rename(tempPath, path, error);
+        if (!ok || error) {
+            LOG("Failed to write world manifest: " + path);
+            std::filesystem::remove(tempPath, error);
+            ok = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            saving = false;
+            if (ok) {
+                dirty = false;
+                onDisk = true;
+            }
+        }
+        saved.notify_all();
+        return ok;
+    }
+
+    // CRC-32 (IEEE), eight bytes per step
+    static uint32_t checksum(const uint8_t* data, size_t size) {
+        static const CrcTables tables = makeCrcTables();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (; size >= 8; data += 8, size -= 8) {
+            uint32_t low, high;
+            std::memcpy(&low, data, 4);
+            std::memcpy(&high, data + 4, 4);
+            low ^= crc;
+            crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+                  tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+        }
+        for (; size > 0; ++data, --size) crc = tables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+private:
+    struct RegionKey {
+        int x, y, z;
+        bool operator==(const RegionKey& other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+    struct RegionKeyHash {
+        size_t operator()(const RegionKey& key) const {
+            return (size_t(uint32_t(key.x)) * 73856093u) ^ (size_t(uint32_t(key.y)) * 19349663u) ^ (size_t(uint32_t(key.z)) * 83492791u);
+        }
+    };
+    struct Region {
+        std::bitset<RegionFile::CHUNKS_PER_REGION> present;
+        std::array<Entry, RegionFile::CHUNKS_PER_REGION> entries{};
+    };
+
+    // On disk per region: its coordinate, the presence bits, then the entries of
+    // present slots in slot order
+    static constexpr size_t PRESENCE_WORDS = RegionFile::CHUNKS_PER_REGION / 64;
+    static constexpr size_t ENTRY_BYTES = 2 * sizeof(uint32_t) + sizeof(uint8_t);
+    using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+    std::string path;
+    std::unordered_map<RegionKey, Region, RegionKeyHash> regions;
+    bool loaded = false;
+    bool onDisk = false;    // The file matches the regions as of the last save
+    bool dirty = false;     // Changed since the last save
+    bool saving = false;
+    size_t writesInFlight = 0;
+    std::mutex mutex;
+    std::condition_variable saved;
+
+    static RegionKey regionKey(const Chunk::ChunkCoord& coord) {
+        return RegionKey{RegionFile::regionCoord(coord.x), RegionFile::regionCoord(coord.y), RegionFile::regionCoord(coord.z)};
+    }
+
+    Entry& insert(const Chunk::ChunkCoord& coord) {
+        Region& region = regions[regionKey(coord)];
+        int slot = RegionFile::slotIndex(coord.x, coord.y, coord.z);
+        if (!region.present[slot]) {
+            region.present[slot] = true;
+            region.entries[slot] = Entry{};
+        }
+        return region.entries[slot];
+    }
+
+    template <typename T>
+    static void put(std::vector<uint8_t>& out, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    static bool get(const uint8_t*& data, const uint8_t* end, T& value) {
+        if (size_t(end - data) < sizeof(T)) return false;
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return true;
+    }
+
+    // Header, regions, then a CRC-32 of everything before it
+    void encode(std::vector<uint8_t>& out) const {
+        put(out, MAGIC);
+        put(out, VERSION);
+        put(out, static_cast<uint32_t>(regions.size()));
+        for (const auto& [key, region] : regions) {
+            put(out, key);
+            for (size_t word = 0; word < PRESENCE_WORDS; ++word) {
+                uint64_t bits = 0;
+                for (int bit = 0; bit < 64; ++bit) {
+                    if (region.present[word * 64 + bit]) bits |= uint64_t(1) << bit;
+                }
+                put(out, bits);
+            }
+            for (int slot = 0; slot < RegionFile::CHUNKS_PER_REGION; ++slot) {
+                if (!region.present[slot]) continue;
+                const Entry& entry = region.entries[slot];
+                put(out, entry.size);
+                put(out, entry.checksum);
+                put(out, entry.flags);
+            }
+        }
+        put(out, checksum(out.data(), out.size()));
+    }
+
+    bool load() {
+        MappedFile file(path);
+        if (!file.isOpen()) return false;
+        const uint8_t* data = file.data();
+        const uint8_t* end = data + file.size();
+
+        uint32_t magic = 0, version = 0, regionCount = 0, stored = 0;
+        if (file.size() < 4 * sizeof(uint32_t)) return invalid();
+        std::memcpy(&stored, end - sizeof(uint32_t), sizeof(uint32_t));
+        end -= sizeof(uint32_t);
+        if (checksum(data, end - data) != stored) return invalid();
+        get(data, end, magic);
+        get(data, end, version);
+        get(data, end, regionCount);
+        if (magic != MAGIC || version != VERSION) return invalid();
+
+        for (uint32_t r = 0; r < regionCount; ++r) {
+            RegionKey key;
+            if (!get(data, end, key)) return invalid();
+            Region& region = regions[key];
+            for (size_t word = 0; word < PRESENCE_WORDS; ++word) {
+                uint64_t bits;
+                if (!get(data, end, bits)) return invalid();
+                for (int bit = 0; bit < 64; ++bit) region.present[word * 64 + bit] = (bits >> bit) & 1;
+            }
+            if (size_t(end - data) < region.present.count() * ENTRY_BYTES) return invalid();
+            for (int slot = 0; slot < RegionFile::CHUNKS_PER_REGION; ++slot) {
+                if (!region.present[slot]) continue;
+                Entry& entry = region.entries[slot];
+                get(data, end, entry.size);
+                get(data, end, entry.checksum);
+                get(data, end, entry.flags);
+            }
+        }
+        if (data != end) return invalid();
+        return true;
+    }
+
+    bool invalid() {
+        LOG("Invalid world manifest, rebuilding it: " + path);
+        regions.clear();
+        return false;
+    }
+
+    static CrcTables makeCrcTables() {
+        CrcTables tables{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+            tables[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t t = 1; t < tables.size(); ++t) tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+        }
+        return tables;
+    }
+};
@@ -41,6 +41,8 @@
 #include "types.h"
 #include "Logger.h"
 #include "Vertex.h"
+#include "VoxelVertex.h"
+#include "Frustum.h"
 #include "Voxel.cpp"
 #include "Chunk.h"
 #include "ChunkManager.h"
@@ -233,15 +235,23 @@ private:
     PhysicsSystem physicsSystem;
     VkPipelineLayout pipelineLayout;
     VkPipeline graphicsPipeline;
+    VkPipeline voxelPipeline; // Chunk meshes: packed VoxelVertex input, same layout as graphicsPipeline
     std::vector<VkBuffer> uniformBuffers;
     std::vector<VmaAllocation> uniformBuffersAllocations;
     VkDescriptorSetLayout descriptorSetLayout;
     VkDescriptorPool descriptorPool;
     std::vector<VkDescriptorSet> descriptorSets;
 
-    // Chunk rendering data
-    std::unordered_map<Chunk::ChunkCoord, std::pair<VkBuffer, VmaAllocation>> chunkVertexBuffers;
-    std::unordered_map<Chunk::ChunkCoord, std::pair<VkBuffer, VmaAllocation>> chunkIndexBuffers;
+    // Chunk rendering data, one set of GPU buffers per mesh section
+    struct ChunkSectionBuffers {
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VmaAllocation vertexAllocation = nullptr;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VmaAllocation indexAllocation = nullptr;
+        uint32_t indexCount = 0;
+        uint32_t quadCapacity = 0; // Quads the buffers can hold, with headroom for patched sections
+    };
+    FlatHashMap<Chunk::ChunkCoord, std::array<ChunkSectionBuffers, Chunk::SECTION_COUNT>> chunkSectionBuffers;
 
     // Player rendering data
     VkBuffer playerVertexBuffer;
@@ -1135,34 +1145,51 @@ private:
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
 
 
-        // Render chunks
+        // Render chunks section by section, skipping sections outside the view frustum
+        glm::mat4 proj = camera.getProjection(swapChainExtent.width / (float) swapChainExtent.height);
+        proj[1][1] *= -1;
+        Frustum viewFrustum(proj * camera.getView());
+
+        syncChunkBuffers();
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, voxelPipeline);
         for (const auto& pair : editor.chunkManager.getLoadedChunks()) {
             const Chunk::ChunkCoord& coord = pair.first;
             const std::unique_ptr<Chunk>& chunk = pair.second;
 
             if (!chunk->empty()) {
-                if (chunk->isDirty() || chunkVertexBuffers.find(coord) == chunkVertexBuffers.end()) {
-                    LOG("chunk->isDirty() recordCommandBuffer: Drawing chunk at " + std::to_string(coord.x) + "," + std::to_string(coord.y) + "," + std::to_string(coord.z) + " with index count: " + std::to_string(chunk->getIndices().size()));
-                    updateChunkBuffers(coord, chunk->getVertices(), chunk->getIndices());
-                }
+                auto buffersIt = chunkSectionBuffers.find(coord);
+                if (buffersIt == chunkSectionBuffers.end()) continue; // Not meshed yet
 
-                // Push model matrix for this chunk
-                glm::mat4 chunkModel = glm::mat4(1.0f);
+                // Push model matrix for this chunk; vertices are chunk-relative voxel corners
+                glm::mat4 chunkModel = glm::translate(glm::mat4(1.0f), chunk->getWorldPosition());
+                chunkModel = glm::scale(chunkModel, glm::vec3(Chunk::VOXEL_SIZE));
 
                 MeshPushConstants constants{};
                 constants.model = chunkModel;
 
                 vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MeshPushConstants), &constants);
 
+                for (int section = 0; section < Chunk::SECTION_COUNT; ++section) {
+                    const ChunkSectionBuffers& buffers = buffersIt->second[section];
+                    if (buffers.indexCount == 0) continue;
+
+                    glm::vec3 boundsMin, boundsMax;
+                    if (!chunk->getSectionBounds(section, boundsMin, boundsMax) ||
+                        !viewFrustum.intersectsAABB(boundsMin, boundsMax)) continue;
 
-                VkBuffer vertexBuffers[] = {chunkVertexBuffers[coord].first};
-                VkDeviceSize offsets[] = {0};
-                vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-                vkCmdBindIndexBuffer(commandBuffer, chunkIndexBuffers[coord].first, 0, VK_INDEX_TYPE_UINT32);
-                vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(chunk->getIndices().size()), 1, 0, 0, 0);
+                    VkBuffer vertexBuffers[] = {buffers.vertexBuffer};
+                    VkDeviceSize offsets[] = {0};
+                    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+                    vkCmdBindIndexBuffer(commandBuffer, buffers.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                    vkCmdDrawIndexed(commandBuffer, buffers.indexCount, 1, 0, 0, 0);
+                }
             }
         }
 
+        // Player and items use the full Vertex format
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+
         // Render player
         if (editor.playerCharacter) {
             // glm::mat4 playerModel = editor.playerCharacter->getModelMatrix();
@@ -1298,6 +1325,7 @@ private:
 
         vkDestroySwapchainKHR(device, swapChain, nullptr);
         vkDestroyPipeline(device, graphicsPipeline, nullptr);
+        vkDestroyPipeline(device, voxelPipeline, nullptr);
         vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 
         // vkDeviceWaitIdle(device);
@@ -1501,6 +1529,23 @@ private:
             throw std::runtime_error("failed to create graphics pipeline!");
         }
 
+        // Voxel pipeline: same state and fragment shader, packed chunk vertices
+        auto voxelVertShaderCode = readFile("../../shaders/voxel.vert.spv");
+        VkShaderModule voxelVertShaderModule = createShaderModule(voxelVertShaderCode);
+        shaderStages[0].module = voxelVertShaderModule;
+
+        auto voxelBindingDescription = VoxelVertex::getBindingDescription();
+        auto voxelAttributeDescriptions = VoxelVertex::getAttributeDescriptions();
+
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(voxelAttributeDescriptions.size());
+        vertexInputInfo.pVertexBindingDescriptions = &voxelBindingDescription;
+        vertexInputInfo.pVertexAttributeDescriptions = voxelAttributeDescriptions.data();
+
+        if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &voxelPipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create voxel pipeline!");
+        }
+
+        vkDestroyShaderModule(device, voxelVertShaderModule, nullptr);
         vkDestroyShaderModule(device, fragShaderModule, nullptr);
         vkDestroyShaderModule(device, vertShaderModule, nullptr);
     }
@@ -1610,81 +1655,168 @@ private:
         vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, &buffer, &allocation, nullptr);
     }
 
-    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    // Copies recorded into one command buffer and submitted together, so a frame's
+    // uploads wait on the queue once; the staging buffers are freed after the submit
+    struct UploadBatch {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        std::vector<std::pair<VkBuffer, VmaAllocation>> stagingBuffers;
+    };
+
+    // Copy data into part of a device-local buffer through a staging buffer
+    void stageUpload(UploadBatch& batch, VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0) {
+        VkBuffer stagingBuffer;
+        VmaAllocation stagingBufferAllocation;
+        createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer, stagingBufferAllocation);
+        void* mapped;
+        vmaMapMemory(allocator, stagingBufferAllocation, &mapped);
+        memcpy(mapped, data, (size_t) size);
+        vmaUnmapMemory(allocator, stagingBufferAllocation);
 
         VkBufferCopy copyRegion{};
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+        vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+        batch.stagingBuffers.emplace_back(stagingBuffer, stagingBufferAllocation);
+    }
 
-        endSingleTimeCommands(commandBuffer);
+    void submitUploads(UploadBatch& batch) {
+        endSingleTimeCommands(batch.commandBuffer);
+        for (const auto& [buffer, allocation] : batch.stagingBuffers) {
+            vmaDestroyBuffer(allocator, buffer, allocation);
+        }
+        batch = UploadBatch{};
     }
 
-    void createChunkBuffers(const Chunk::ChunkCoord& coord, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-        // Create vertex buffer
-        VkDeviceSize vertexBufferSize = sizeof(vertices[0]) * vertices.size();
-        VkBuffer vertexStagingBuffer;
-        VmaAllocation vertexStagingBufferAllocation;
-        createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, vertexStagingBuffer, vertexStagingBufferAllocation);
-        void* vertexData;
-        vmaMapMemory(allocator, vertexStagingBufferAllocation, &vertexData);
-        memcpy(vertexData, vertices.data(), (size_t) vertexBufferSize);
-        vmaUnmapMemory(allocator, vertexStagingBufferAllocation);
+    // quadCapacity reserves room beyond the mesh so patched sections can grow in place
+    void createSectionBuffers(UploadBatch& batch, ChunkSectionBuffers& buffers, const std::vector<VoxelVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t quadCapacity = 0) {
+        buffers.quadCapacity = std::max(quadCapacity, static_cast<uint32_t>(vertices.size() / 4));
 
-        VkBuffer vertexBuffer;
-        VmaAllocation vertexBufferAllocation;
-        createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer, vertexBufferAllocation);
-        copyBuffer(vertexStagingBuffer, vertexBuffer, vertexBufferSize);
-        vmaDestroyBuffer(allocator, vertexStagingBuffer, vertexStagingBufferAllocation);
-        chunkVertexBuffers[coord] = {vertexBuffer, vertexBufferAllocation};
+        createBuffer(sizeof(VoxelVertex) * 4 * buffers.quadCapacity, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, buffers.vertexBuffer, buffers.vertexAllocation);
+        stageUpload(batch, buffers.vertexBuffer, vertices.data(), sizeof(vertices[0]) * vertices.size());
 
-        // Create index buffer
-        VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
-        LOG("createChunkBuffers: Index vector size: " + std::to_string(indices.size()) + ", calculated buffer size: " + std::to_string(indexBufferSize));
-        VkBuffer indexStagingBuffer;
-        VmaAllocation indexStagingBufferAllocation;
-        createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, indexStagingBuffer, indexStagingBufferAllocation);
-        void* indexData;
-        vmaMapMemory(allocator, indexStagingBufferAllocation, &indexData);
-        memcpy(indexData, indices.data(), (size_t) indexBufferSize);
-        vmaUnmapMemory(allocator, indexStagingBufferAllocation);
-
-        VkBuffer indexBuffer;
-        VmaAllocation indexBufferAllocation;
-        createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, indexBuffer, indexBufferAllocation);
-        copyBuffer(indexStagingBuffer, indexBuffer, indexBufferSize);
-        vmaDestroyBuffer(allocator, indexStagingBuffer, indexStagingBufferAllocation);
-        chunkIndexBuffers[coord] = {indexBuffer, indexBufferAllocation};
-        LOG("createChunkBuffers: Index buffer created for chunk " + std::to_string(coord.x) + "," + std::to_string(coord.y) + "," + std::to_string(coord.z) + ". Handle: " + std::to_string((uint64_t)indexBuffer) + ", Allocation: " + std::to_string((uint64_t)indexBufferAllocation));
-        
-        // Mark chunk as not dirty after buffers are updated
-        // We need to get the chunk object from the chunk manager to set its dirty flag
-        Chunk* chunkPtr = editor.chunkManager.getChunk(coord);
-        if (chunkPtr) {
-            chunkPtr->meshDirty = false;
+        createBuffer(sizeof(uint32_t) * 6 * buffers.quadCapacity, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, buffers.indexBuffer, buffers.indexAllocation);
+        stageUpload(batch, buffers.indexBuffer, indices.data(), sizeof(indices[0]) * indices.size());
+        buffers.indexCount = static_cast<uint32_t>(indices.size());
+    }
+
+    void destroySectionBuffers(ChunkSectionBuffers& buffers) {
+        if (buffers.vertexBuffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, buffers.vertexBuffer, buffers.vertexAllocation);
         }
+        if (buffers.indexBuffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, buffers.indexBuffer, buffers.indexAllocation);
+        }
+        buffers = ChunkSectionBuffers{};
     }
 
-    void updateChunkBuffers(const Chunk::ChunkCoord& coord, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-        vkDeviceWaitIdle(device);
-        // Destroy existing buffers
-        destroyChunkBuffers(coord);
-        // Recreate buffers with new data
-        createChunkBuffers(coord, vertices, indices);
+    // Re-upload only the sections whose meshes were rebuilt. Sections patched by an
+    // edit stroke upload just the quads that changed while they fit the buffers.
+    void updateChunkBuffers(UploadBatch& batch, const Chunk::ChunkCoord& coord, Chunk& chunk) {
+        uint64_t sections = chunk.takePendingUploads();
+        auto& sectionBuffers = chunkSectionBuffers[coord];
+        for (uint64_t bits = sections; bits; bits &= bits - 1) {
+            int section = std::countr_zero(bits);
+            ChunkSectionBuffers& buffers = sectionBuffers[section];
+            const Chunk::SectionMesh& mesh = chunk.getSectionMesh(section);
+            uint32_t quadCount = static_cast<uint32_t>(mesh.vertices.size() / 4);
+            uint32_t firstQuad, endQuad;
+            bool patched = chunk.isSectionPatched(section);
+            bool hasPatch = chunk.takePatchedRange(section, firstQuad, endQuad);
+
+            if (patched && buffers.vertexBuffer != VK_NULL_HANDLE && quadCount <= buffers.quadCapacity) {
+                if (hasPatch) {
+                    stageUpload(batch, buffers.vertexBuffer, &mesh.vertices[firstQuad * 4], sizeof(VoxelVertex) * 4 * (endQuad - firstQuad), sizeof(VoxelVertex) * 4 * firstQuad);
+                    stageUpload(batch, buffers.indexBuffer, &mesh.indices[firstQuad * 6], sizeof(uint32_t) * 6 * (endQuad - firstQuad), sizeof(uint32_t) * 6 * firstQuad);
+                }
+                buffers.indexCount = quadCount * 6;
+                continue;
+            }
+
+            // Destroy existing buffers
+            destroySectionBuffers(buffers);
+            // Recreate buffers with new data; sections without faces keep none
+            if (!mesh.indices.empty()) {
+                createSectionBuffers(batch, buffers, mesh.vertices, mesh.indices, patched ? quadCount + quadCount / 2 + 64 : 0);
+            }
+        }
     }
 
     void destroyChunkBuffers(const Chunk::ChunkCoord& coord) {
-        auto vertexIt = chunkVertexBuffers.find(coord);
-        if (vertexIt != chunkVertexBuffers.end()) {
-            vmaDestroyBuffer(allocator, vertexIt->second.first, vertexIt->second.second);
-            chunkVertexBuffers.erase(vertexIt);
+        auto it = chunkSectionBuffers.find(coord);
+        if (it == chunkSectionBuffers.end()) return;
+        for (ChunkSectionBuffers& buffers : it->second) {
+            destroySectionBuffers(buffers);
+        }
+        chunkSectionBuffers.erase(it);
+    }
+
+    // Percentiles of each streaming stage over its recent samples, for tuning the
+    // load radius against frame time
+    void drawStreamingStats() {
+        ImGui::Begin("Streaming");
+        StreamingStats& stats = editor.chunkManager.getStreamingStats();
+        if (ImGui::BeginTable("StreamingStats", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("Count");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p95");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableSetupColumn("Max");
+            ImGui::TableHeadersRow();
+            for (size_t m = 0; m < StreamingStats::METRIC_COUNT; ++m) {
+                StreamingStats::Metric metric = static_cast<StreamingStats::Metric>(m);
+                StreamingStats::Summary summary = stats.summary(metric);
+                const char* format = StreamingStats::isTiming(metric) ? "%.2f ms" : "%.0f";
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(StreamingStats::name(metric));
+                ImGui::TableNextColumn(); ImGui::Text("%zu", summary.total);
+                ImGui::TableNextColumn(); ImGui::Text(format, summary.p50);
+                ImGui::TableNextColumn(); ImGui::Text(format, summary.p95);
+                ImGui::TableNextColumn(); ImGui::Text(format, summary.p99);
+                ImGui::TableNextColumn(); ImGui::Text(format, summary.max);
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::Button("Export CSV")) {
+            editor.chunkManager.exportStreamingStats("streaming_stats.csv");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset")) {
+            stats.reset();
+        }
+        ImGui::End();
+    }
+
+    // Bring the GPU buffers in line with the loaded chunks before a frame is
+    // recorded: free those of unloaded chunks and upload rebuilt sections. Earlier
+    // frames may still read the buffers being replaced, so this waits for the
+    // device once, and submits every upload in one batch
+    void syncChunkBuffers() {
+        const auto& loadedChunks = editor.chunkManager.getLoadedChunks();
+        std::vector<Chunk::ChunkCoord> unloaded;
+        for (const auto& [coord, buffers] : chunkSectionBuffers) {
+            if (loadedChunks.find(coord) == loadedChunks.end()) unloaded.push_back(coord);
         }
+        std::vector<std::pair<Chunk::ChunkCoord, Chunk*>> pending;
+        for (const auto& [coord, chunk] : loadedChunks) {
+            if (!chunk->empty() && chunk->hasPendingUpload()) pending.emplace_back(coord, chunk.get());
+        }
+        if (unloaded.empty() && pending.empty()) return;
+
+        vkDeviceWaitIdle(device);
+        for (const auto& coord : unloaded) {
+            destroyChunkBuffers(coord);
+        }
+        if (pending.empty()) return;
 
-        auto indexIt = chunkIndexBuffers.find(coord);
-        if (indexIt != chunkIndexBuffers.end()) {
-            vmaDestroyBuffer(allocator, indexIt->second.first, indexIt->second.second);
-            chunkIndexBuffers.erase(indexIt);
+        StreamingStats::Timer uploadTimer;
+        UploadBatch batch;
+        batch.commandBuffer = beginSingleTimeCommands();
+        for (const auto& [coord, chunk] : pending) {
+            updateChunkBuffers(batch, coord, *chunk);
         }
+        submitUploads(batch);
+        editor.chunkManager.getStreamingStats().record(StreamingStats::Metric::Upload, uploadTimer.lap());
     }
 
     static std::vector<char> readFile(const std::string& filename) {
@@ -1724,6 +1856,7 @@ private:
 
         initializeUniformBuffers(); // running update in drawFrame()
 
+        StreamingStats::Timer frameTimer;
         while (!glfwWindowShouldClose(window)) {
             glfwPollEvents();
 
@@ -1902,7 +2035,7 @@ private:
 
                         if (editor.isPainting) {
                             // Add the voxel
-                            editor.chunkManager.setVoxelWorld(newVoxelPos, Chunk::VoxelData(glm::vec4(voxelColor[0], voxelColor[1], voxelColor[2], voxelColor[3]), 1, editor.selectedTextureId)); // Red voxel
+                            editor.chunkManager.setVoxelWorld(newVoxelPos, Chunk::VoxelData(glm::vec4(voxelColor[0], voxelColor[1], voxelColor[2], voxelColor[3]), 1, editor.selectedTextureId), true); // Red voxel
                             paintedVoxelsInStroke.insert(newVoxelPos);
                         } else if (editor.isPaintingComponent) {
                             // if (editor.isPaintingComponentType == ComponentType::Tree) {
@@ -1985,7 +2118,8 @@ private:
                     }
                 }
             } else if (!isLeftMouseButtonPressed && wasLeftMouseButtonPressed) {
-                // Mouse button released, save modified chunks
+                // Mouse button released, hand patched meshes back to the greedy mesher and save modified chunks
+                editor.chunkManager.finishEditStroke();
                 editor.chunkManager.saveModifiedChunks();
                 paintedVoxelsInStroke.clear();
             }
@@ -2152,26 +2286,56 @@ private:
                 ImGui::Combo("Stone", &editor.terrainStoneTextureId, c_str_textureNames.data(), static_cast<int>(c_str_textureNames.size()));
             }
 
-            if (ImGui::Button("Generate World")) {
-                editor.chunkManager.terrainGenerator.setSeed(seed);
-                editor.chunkManager.terrainGenerator.setFrequency(frequency);
-                editor.chunkManager.terrainGenerator.setOctaves(octaves);
+            if (editor.chunkManager.isGeneratingWorld()) {
+                // Runs in the background; chunks stream in once it is done
+                ChunkManager::WorldGenerationProgress progress = editor.chunkManager.getWorldGenerationProgress();
+                float fraction = progress.total ? static_cast<float>(progress.written) / progress.total : 1.0f;
+                std::string label = std::to_string(progress.written) + " / " + std::to_string(progress.total) + " chunks";
+                ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f), label.c_str());
+                if (progress.cancelled) {
+                    ImGui::Text("Cancelling...");
+                } else if (ImGui::Button("Cancel")) {
+                    editor.chunkManager.cancelWorldGeneration();
+                }
+            } else if (ImGui::Button("Generate World")) {
                 // Update the terrain generator with selected textures
-                editor.chunkManager.terrainGenerator = TerrainGenerator(editor.terrainGrassTextureId, editor.terrainDirtTextureId, editor.terrainStoneTextureId);
+                TerrainGenerator generator(editor.terrainGrassTextureId, editor.terrainDirtTextureId, editor.terrainStoneTextureId);
+                generator.setSeed(seed);
+                generator.setFrequency(frequency);
+                generator.setOctaves(octaves);
+                editor.chunkManager.setTerrainGenerator(generator);
                 editor.chunkManager.generateWorld(numChunksX, numChunksY, numChunksZ);
-                editor.chunkManager.updateLoadedChunks(camera.position3D);
             }
 
             ImGui::End();
 
+            drawStreamingStats();
+
             ImGui::Begin("Engine");
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 
                         1000.0f / ImGui::GetIO().Framerate, 
                         ImGui::GetIO().Framerate);
 
-            ImGui::Text("Active Physics Bodies %i", 
+            ImGui::Text("Active Physics Bodies %i",
                         activePhysicsBodies.size());
 
+            ChunkCache::Stats cacheStats = editor.chunkManager.getMemoryCacheStats();
+            int cacheBudgetMb = static_cast<int>(cacheStats.budget >> 20);
+            if (ImGui::SliderInt("Chunk Cache Budget (MB)", &cacheBudgetMb, 0, 2048)) {
+                editor.chunkManager.setMemoryCacheBudget(static_cast<size_t>(cacheBudgetMb) << 20);
+            }
+            size_t cacheLookups = cacheStats.hits + cacheStats.misses;
+            ImGui::Text("Chunk Cache %zu chunks, %.1f MB", cacheStats.entries, cacheStats.bytes / (1024.0 * 1024.0));
+            ImGui::Text("Chunk Cache hits %zu, misses %zu (%.0f%% hit), evicted %zu",
+                        cacheStats.hits, cacheStats.misses,
+                        cacheLookups ? 100.0 * cacheStats.hits / cacheLookups : 0.0,
+                        cacheStats.evictions);
+
+            float prefetchSeconds = editor.chunkManager.getPrefetchSeconds();
+            if (ImGui::SliderFloat("Chunk Prefetch (s)", &prefetchSeconds, 0.0f, 3.0f)) {
+                editor.chunkManager.setPrefetchSeconds(prefetchSeconds);
+            }
+
             if (ImGui::Button("Add Character")) {
                 if (!editor.playerCharacter) {
                     editor.playerCharacter = std::make_unique<PlayerCharacter>(physicsSystem, glm::vec3(25.0f, 16.0f, 25.0f));
@@ -2311,8 +2475,9 @@ private:
             ImGui::Render();
 
             // Update chunk manager
-            editor.chunkManager.updateLoadedChunks(camera.position3D);
+            editor.chunkManager.updateLoadedChunks(camera.position3D, camera.target - camera.position3D);
             editor.chunkManager.rebuildDirtyChunks();
+            editor.chunkManager.integrateFinishedMeshes();
 
             // --- Physics Body Management ---
 
@@ -2357,6 +2522,7 @@ private:
             // --- End Physics Body Management ---
 
             drawFrame();
+            editor.chunkManager.getStreamingStats().record(StreamingStats::Metric::Frame, frameTimer.lap());
         }
 
         LOG("Exiting main loop");
@@ -2367,6 +2533,13 @@ private:
     void cleanup() {
         LOG("Cleaning up VulkanEngine");
 
+        // Fold this session's edits into the chunks, keep its meshes so the next
+        // one can skip rebuilding them, and wait for the background writer to get
+        // everything on disk
+        editor.chunkManager.compactJournal();
+        editor.chunkManager.saveMeshCaches();
+        editor.chunkManager.flushSaves();
+
         delete textureManager;
 
         cleanupSwapChain();
@@ -2381,15 +2554,12 @@ private:
         destroyPlayerBuffers();
         destroyItemBuffers();
 
-        for (auto const& [coord, buffers] : chunkVertexBuffers) {
-            vmaDestroyBuffer(allocator, buffers.first, buffers.second);
-        }
-        chunkVertexBuffers.clear();
-
-        for (auto const& [coord, buffers] : chunkIndexBuffers) {
-            vmaDestroyBuffer(allocator, buffers.first, buffers.second);
+        for (auto& [coord, sections] : chunkSectionBuffers) {
+            for (ChunkSectionBuffers& buffers : sections) {
+                destroySectionBuffers(buffers);
+            }
         }
-        chunkIndexBuffers.clear();
+        chunkSectionBuffers.clear();
 
         // destroy here, not in class, to be centralized for now
         if (editor.playerCharacter) {